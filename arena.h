@@ -0,0 +1,129 @@
+/**
+ * @file arena.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief arena (bump) allocator for tensor, vector and matrix storage.
+ */
+#ifndef _ARENA_H_
+#define _ARENA_H_
+#include <stdlib.h>
+#include <assert.h>
+#include <atomic>
+#include <vector>
+#include <type_traits>
+
+// Arena_t class
+// Hands out memory from large chunks by bumping an offset; individual allocations are never freed. reset() releases 
+// everything at once and rewinds to the first chunk, keeping the chunks so the next layer or trial allocates nothing 
+// from the system. Tensor_t, Vector_t and Matrix_t take their element storage from the thread's current arena 
+// (see ArenaScope_t) and fall back to the heap when there is none. An arena must only be used by one thread at a time.
+class Arena_t {
+public:
+	// Constructor
+	Arena_t(size_t _chunkSize = 1 << 20) : chunkSize(_chunkSize), chunk(0), offset(0), inUse(0), peakInUse(0) {}
+
+	// Destructor
+	virtual ~Arena_t() {
+		for (size_t c = 0; c < chunks.size(); c++) {
+			free(chunks[c].base);
+			reserved() -= chunks[c].size;
+		}
+	}
+
+	// allocate "bytes" bytes aligned to "align" (a power of 2)
+	void *allocate(size_t bytes, size_t align = 64) {
+		for (;;) {
+			if (chunk < chunks.size()) {
+				size_t start = (offset + align - 1) & ~(align - 1);
+				if (start + bytes <= chunks[chunk].size) {
+					offset = start + bytes;
+					inUse += bytes;
+					if (inUse > peakInUse) peakInUse = inUse;
+					return chunks[chunk].base + start;
+				}
+				// doesn't fit; move on to the next chunk (reused after a reset) or add one
+				chunk++;
+				offset = 0;
+				if (chunk < chunks.size())
+					continue;
+			}
+			size_t size = bytes + align > chunkSize ? bytes + align : chunkSize;
+			chunk_t c;
+			c.base = (char *) aligned_alloc(64, (size + 63) & ~(size_t) 63);
+			c.size = size;
+			assert(c.base != NULL);
+			chunks.push_back(c);
+			chunk = chunks.size() - 1;
+			offset = 0;
+			size_t now = reserved() += size;
+			for (size_t peak = peakReserved(); now > peak && !peakReserved().compare_exchange_weak(peak, now); )
+				;
+		}
+	}
+
+	// release all allocations
+	void reset() { chunk = 0; offset = 0; inUse = 0; }
+
+	// statistics: bytes handed out since the last reset, the most ever handed out, and the chunk memory held
+	inline size_t used() const { return inUse; }
+	inline size_t peak() const { return peakInUse; }
+	size_t capacity() const {
+		size_t total = 0;
+		for (size_t c = 0; c < chunks.size(); c++)
+			total += chunks[c].size;
+		return total;
+	}
+
+	// the calling thread's current arena (NULL = heap)
+	static Arena_t *&current() { static thread_local Arena_t *arena = NULL; return arena; }
+
+	// chunk memory held by all arenas in the process, now and at its peak
+	static std::atomic<size_t>& reserved() { static std::atomic<size_t> bytes(0); return bytes; }
+	static std::atomic<size_t>& peakReserved() { static std::atomic<size_t> bytes(0); return bytes; }
+
+private:
+	struct chunk_t {
+		char *base;
+		size_t size;
+	};
+	std::vector<chunk_t> chunks;
+	const size_t chunkSize;
+	size_t chunk, offset;
+	size_t inUse, peakInUse;
+};
+
+// ArenaScope_t class
+// Makes "arena" the calling thread's current arena for the lifetime of the scope, then resets it and restores the 
+// previous one. Everything allocated from the arena inside the scope must be gone (or never touched again) by then. 
+// A NULL arena makes the scope allocate from the heap.
+class ArenaScope_t {
+public:
+	ArenaScope_t(Arena_t *_arena) : arena(_arena), prev(Arena_t::current()) { Arena_t::current() = arena; }
+	~ArenaScope_t() {
+		if (arena)
+			arena->reset();
+		Arena_t::current() = prev;
+	}
+
+private:
+	Arena_t *arena, *prev;
+};
+
+// storage helpers for the tensor, vector and matrix classes; "arena" is where the storage came from (NULL = heap).
+// Storage is 64-byte aligned either way.
+template <typename T>
+inline T *arenaAllocate(Arena_t *arena, int len) {
+	static_assert(std::is_trivially_destructible<T>::value, "arena storage is never destructed");
+	size_t align = alignof(T) > 64 ? alignof(T) : 64;
+	if (arena)
+		return (T *) arena->allocate(len * sizeof(T), align);
+	return (T *) aligned_alloc(align, (len * sizeof(T) + align - 1) & ~(align - 1));
+}
+
+template <typename T>
+inline void arenaFree(Arena_t *arena, T *data) {
+	if (!arena)
+		free(data);
+}
+
+#endif // _ARENA_H_
@@ -0,0 +1,215 @@
+/**
+ * @file bench.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief reproducible benchmark suite over a fixed catalog of conv shapes.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "main.h"
+#include "tensor.h"
+#include "conv.h"
+#include "packed.h"
+#include "counters.h"
+#include "epilogue.h"
+#include "hwmm.h"
+#include "tune.h"
+#include "timer.h"
+
+// forward declarations
+extern Tensor_t<int8_t> *simulatedConv2D(Tensor_t<int8_t> *, TensorArray_t<int8_t> *, const conv2DParams_t &, const PackedFilters_t<int8_t> *, hwMMcounters_t *, const hwMMepilogue_t *, const convBand_t *);
+extern int simulatedConv2DDataflow(Tensor_t<int8_t> *, TensorArray_t<int8_t> *, const conv2DParams_t &, const PackedFilters_t<int8_t> *, const hwMMepilogue_t *, const convBand_t *);
+
+// named conv layer shapes; activation W x H x D, C filters of KW x KH x D / groups
+struct benchShape_t {
+	const char *name;
+	int W, H, D;
+	int C, KW, KH;
+	int stride;
+	int padding;
+	int groups;
+};
+
+static const benchShape_t benchShapes[] = {
+	{ "resnet50_conv1",		224, 224, 3,	64, 7, 7,	2, CONV_PAD_SAME,	1 },
+	{ "resnet50_res2a_3x3",	56, 56, 64,		64, 3, 3,	1, CONV_PAD_SAME,	1 },
+	{ "resnet50_res3a_1x1",	28, 28, 256,	128, 1, 1,	1, CONV_PAD_VALID,	1 },
+	{ "resnet50_res4a_3x3",	14, 14, 256,	256, 3, 3,	1, CONV_PAD_SAME,	1 },
+	{ "resnet50_res5a_3x3",	7, 7, 512,		512, 3, 3,	1, CONV_PAD_SAME,	1 },
+	{ "mobilenet_conv1",	224, 224, 3,	32, 3, 3,	2, CONV_PAD_SAME,	1 },
+	{ "mobilenet_dw2",		112, 112, 32,	32, 3, 3,	1, CONV_PAD_SAME,	32 },
+	{ "mobilenet_pw2",		112, 112, 32,	64, 1, 1,	1, CONV_PAD_VALID,	1 },
+	{ "mobilenet_dw13",		7, 7, 1024,		1024, 3, 3,	1, CONV_PAD_SAME,	1024 },
+	{ "mobilenet_pw13",		7, 7, 1024,		1024, 1, 1,	1, CONV_PAD_VALID,	1 },
+};
+
+// HW multiplier grid
+static const int benchN[] = { 8, 16, 32 };
+static const int benchP[] = { 8, 16, 32 };
+
+// fixed seed and data range, so every run of the suite simulates the same data
+static const unsigned benchSeed = 20191109;
+static const int benchMaxInt = 127;
+
+// one result row
+struct benchResult_t {
+	const benchShape_t *shape;
+	int N, P;
+	int repeats;
+	double minTime, medianTime, p99Time;		// seconds
+	double macs;								// useful MACs of the layer
+	int dataflow;								// the dataflow that ran (never CONV_FLOW_AUTO)
+	hwMMcounters_t counters;
+};
+
+// fill a buffer with random 8-bit data
+static void fillRandom(int8_t *data, int len, std::mt19937& gen) {
+	std::uniform_int_distribution<> randData(-benchMaxInt, benchMaxInt);
+	for (int i = 0; i < len; i++)
+		data[i] = randData(gen);
+}
+
+// nearest rank percentile of sorted samples
+static double percentile(const std::vector<double>& sorted, double pct) {
+	int rank = (int) (pct / 100.0 * sorted.size() + 0.999999);
+	if (rank < 1) rank = 1;
+	if (rank > (int) sorted.size()) rank = sorted.size();
+	return sorted[rank - 1];
+}
+
+// run one shape on one multiplier configuration
+static benchResult_t benchCase(const benchShape_t& shape, int shapeIndex, int N, int P, int repeats) {
+	std::mt19937 gen(benchSeed + shapeIndex);
+	TensorArray_t<int8_t> acts(1, shape.W, shape.H, shape.D, (tensorLayout_t) option_layout);
+	TensorArray_t<int8_t> filtSet(shape.C, shape.KW, shape.KH, shape.D / shape.groups, (tensorLayout_t) option_layout);
+	conv2DParams_t params(shape.stride, shape.stride, 1, 1, shape.padding, shape.groups);
+	conv2DGeometry_t geom(shape.W, shape.H, shape.KW, shape.KH, params);
+	std::vector<double> times;
+	benchResult_t result;
+
+	fillRandom(acts.buffer(), acts.count() * acts.stride(), gen);
+	fillRandom(filtSet.buffer(), filtSet.count() * filtSet.stride(), gen);
+	hwMMepilogue_t epilogue = hwMMepilogue_t::calibrate(option_accum, filtSet, benchMaxInt);
+	epilogue.setActivation(option_activation, option_clampMin, option_clampMax);
+	hwMM.N = N;
+	hwMM.P = P;
+
+	// packing is part of the timed work, as in a single call without a cached packed filter set;
+	// counters are taken from the first timed run only, they are the same for every run
+	for (int r = -option_warmup; r < repeats; r++) {
+		Timer timer;
+		timer.start();
+		Tensor_t<int8_t> *res = simulatedConv2D(acts.pointer(0), &filtSet, params, NULL, r == 0 ? &result.counters : NULL, &epilogue, NULL);
+		timer.stop();
+		delete res;
+		if (r >= 0)
+			times.push_back(*timer);
+	}
+	std::sort(times.begin(), times.end());
+
+	result.shape = &shape;
+	result.N = N;
+	result.P = P;
+	result.repeats = repeats;
+	result.minTime = times.front();
+	result.medianTime = times.size() & 1 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+	result.p99Time = percentile(times, 99.0);
+	result.macs = (double) geom.OW * geom.OH * shape.C * shape.KW * shape.KH * (shape.D / shape.groups);
+	result.dataflow = simulatedConv2DDataflow(acts.pointer(0), &filtSet, params, NULL, &epilogue, NULL);
+	return result;
+}
+
+// CSV output
+static void writeCSV(std::ostream& os, const std::vector<benchResult_t>& results) {
+	os << "name,W,H,D,C,KW,KH,stride,padding,groups,N,P,accum,threads,kernel,specialized,group_pack,layout,dataflow,engines,load_bytes,repeats,min_ms,median_ms,p99_ms,macs_per_sec,invocations,mac_util,row_util,col_util,depth_util,"
+			"vector_bytes,matrix_bytes,matrix_loads,writebacks,engine_cycles,port_util" << std::endl;
+	for (size_t i = 0; i < results.size(); i++) {
+		const benchResult_t& r = results[i];
+		const benchShape_t& s = *r.shape;
+		os << s.name << "," << s.W << "," << s.H << "," << s.D << "," << s.C << "," << s.KW << "," << s.KH << "," << s.stride << "," << 
+				(s.padding == CONV_PAD_SAME ? "SAME" : "VALID") << "," << s.groups << "," << r.N << "," << r.P << "," << hwMMepilogue_t(option_accum).name() << "," << option_threads << "," << 
+				hwMMkernelName(option_kernel) << "," << (option_specialize && hwMMspecialized(r.P)) << "," << option_groupPack << "," << tensorLayoutName(option_layout) << "," << convDataflowName(r.dataflow) << "," << hwMM.engines << "," << hwMM.loadBytes << "," << 
+				r.repeats << "," << r.minTime * 1.0e3 << "," << r.medianTime * 1.0e3 << "," << r.p99Time * 1.0e3 << "," << r.macs / r.medianTime << "," << 
+				r.counters.invocations << "," << r.counters.macUtilization() << "," << r.counters.rowUtilization() << "," << r.counters.colUtilization() << "," << 
+				r.counters.depthUtilization() << "," << r.counters.vectorBytes << "," << r.counters.matrixBytes << "," << r.counters.matrixLoads << "," << 
+				r.counters.writebacks << "," << r.counters.engineCycles << "," << r.counters.portUtilization() << std::endl;
+	}
+}
+
+// JSON output
+static void writeJSON(std::ostream& os, const std::vector<benchResult_t>& results) {
+	os << "{" << std::endl;
+	os << "  \"seed\": " << benchSeed << "," << std::endl;
+	os << "  \"accum\": \"" << hwMMepilogue_t(option_accum).name() << "\"," << std::endl;
+	os << "  \"threads\": " << option_threads << "," << std::endl;
+	os << "  \"kernel\": \"" << hwMMkernelName(option_kernel) << "\"," << std::endl;
+	os << "  \"warmup\": " << option_warmup << "," << std::endl;
+	os << "  \"group_pack\": " << option_groupPack << "," << std::endl;
+	os << "  \"layout\": \"" << tensorLayoutName(option_layout) << "\"," << std::endl;
+	os << "  \"dataflow_option\": \"" << convDataflowName(option_dataflow) << "\"," << std::endl;
+	os << "  \"engines\": " << hwMM.engines << "," << std::endl;
+	os << "  \"load_bytes\": " << hwMM.loadBytes << "," << std::endl;
+	os << "  \"results\": [" << std::endl;
+	for (size_t i = 0; i < results.size(); i++) {
+		const benchResult_t& r = results[i];
+		const benchShape_t& s = *r.shape;
+		os << "    { \"name\": \"" << s.name << "\", \"W\": " << s.W << ", \"H\": " << s.H << ", \"D\": " << s.D << ", \"C\": " << s.C << 
+				", \"KW\": " << s.KW << ", \"KH\": " << s.KH << ", \"stride\": " << s.stride << ", \"padding\": \"" << (s.padding == CONV_PAD_SAME ? "SAME" : "VALID") << 
+				"\", \"groups\": " << s.groups << ", \"N\": " << r.N << ", \"P\": " << r.P << ", \"specialized\": " << (option_specialize && hwMMspecialized(r.P)) << ", \"dataflow\": \"" << convDataflowName(r.dataflow) << "\", \"repeats\": " << r.repeats << 
+				", \"min_ms\": " << r.minTime * 1.0e3 << ", \"median_ms\": " << r.medianTime * 1.0e3 << ", \"p99_ms\": " << r.p99Time * 1.0e3 << 
+				", \"macs_per_sec\": " << r.macs / r.medianTime << ", \"invocations\": " << r.counters.invocations << 
+				", \"mac_util\": " << r.counters.macUtilization() << ", \"row_util\": " << r.counters.rowUtilization() << ", \"col_util\": " << r.counters.colUtilization() << 
+				", \"depth_util\": " << r.counters.depthUtilization() << ", \"vector_bytes\": " << r.counters.vectorBytes << ", \"matrix_bytes\": " << r.counters.matrixBytes << 
+				", \"matrix_loads\": " << r.counters.matrixLoads << ", \"writebacks\": " << r.counters.writebacks << 
+				", \"engine_cycles\": " << r.counters.engineCycles << ", \"port_util\": " << r.counters.portUtilization() << " }" << (i + 1 < results.size() ? "," : "") << std::endl;
+	}
+	os << "  ]" << std::endl;
+	os << "}" << std::endl;
+}
+
+// benchSuite: run every catalog shape on every (N, P) of the grid, "repeats" timed runs each after option_warmup 
+// untimed ones. Results go to "ofile" (JSON if its name ends in ".json", CSV otherwise) or as CSV to stdout.
+// The simulator options that matter (threads, kernel, specialize, implicit, arena, groupPack, dataflow and tuning) are taken from the
+// command line as usual. With --tune, a case is tuned in its first run, which is a warmup run unless --warmup is 0.
+// Each result reports the dataflow that ran, which with --dataflow 0 comes from the tuning cache (see selectDataflow()).
+void benchSuite(int repeats, const char *ofile) {
+	std::vector<benchResult_t> results;
+	int savedN = hwMM.N, savedP = hwMM.P;
+
+	for (size_t s = 0; s < sizeof(benchShapes) / sizeof(benchShapes[0]); s++)
+		for (size_t n = 0; n < sizeof(benchN) / sizeof(benchN[0]); n++)
+			for (size_t p = 0; p < sizeof(benchP) / sizeof(benchP[0]); p++) {
+				results.push_back(benchCase(benchShapes[s], s, benchN[n], benchP[p], repeats));
+				if (option_verbose) {
+					const benchResult_t& r = results.back();
+					std::cerr.precision(3);
+					std::cerr << r.shape->name << " on " << r.N << "x" << r.P << ": median " << r.medianTime * 1.0e3 << " msec, " << 
+							r.macs / r.medianTime * 1.0e-9 << " GMAC/s, " << 100.0 * r.counters.macUtilization() << "% MAC utilization" << std::endl;
+				}
+			}
+	hwMM.N = savedN;
+	hwMM.P = savedP;
+
+	// write results
+	if (ofile) {
+		std::filebuf fb;
+		if (fb.open(ofile, std::ios::out)) {
+			std::ostream os(&fb);
+			size_t len = strlen(ofile);
+			if (len > 5 && !strcmp(ofile + len - 5, ".json"))
+				writeJSON(os, results);
+			else
+				writeCSV(os, results);
+			fb.close();
+		} else
+			perror(ofile);
+	} else
+		writeCSV(std::cout, results);
+}
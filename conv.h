@@ -0,0 +1,89 @@
+/**
+ * @file conv.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief conv2D layer parameters and output geometry.
+ */
+#ifndef _CONV_H_
+#define _CONV_H_
+#include <sstream>
+#include <string>
+
+// padding modes
+enum convPadding_t {
+	CONV_PAD_VALID = 0,			// no padding; the filter window never leaves the activation
+	CONV_PAD_SAME = 1			// zero padding so that output size = ceil(input size / stride), as in tf.nn.conv2d
+};
+
+// reference used to check simulated results
+enum convReference_t {
+	CONV_REF_FLOAT = 0,			// float direct convolution; rms error only
+	CONV_REF_INT = 1,			// exact int32 convolution; rms error and bit for bit check of the 8-bit wraparound results
+	CONV_REF_BOTH = 2			// int32 check, with the float reference as a secondary check
+};
+
+// conv2DParams_t: per layer convolution parameters. Defaults are stride 1, no dilation, VALID padding and one group.
+// With G groups, the D activation channels and the C filters are split in G equal groups; filter c has depth D / G and 
+// reads activation channels [g * D / G, (g + 1) * D / G) of its group g = c / (C / G). Depthwise convolution is G = D.
+struct conv2DParams_t {
+	int strideW, strideH;		// output step across the activation
+	int dilationW, dilationH;	// spacing between filter taps
+	int padding;				// convPadding_t
+	int groups;					// G
+
+	conv2DParams_t(int _strideW = 1, int _strideH = 1, int _dilationW = 1, int _dilationH = 1, int _padding = CONV_PAD_VALID, int _groups = 1) : 
+		strideW(_strideW), strideH(_strideH), dilationW(_dilationW), dilationH(_dilationH), padding(_padding), groups(_groups) {}
+
+	// true for stride 1, no dilation, VALID padding and one group
+	inline bool isDefault() const { return strideW == 1 && strideH == 1 && dilationW == 1 && dilationH == 1 && padding == CONV_PAD_VALID && groups == 1; }
+
+	// generate a string with the parameters
+	std::string operator() () const {
+		std::ostringstream buffer;
+		buffer << "stride [" << strideW << "," << strideH << "], dilation [" << dilationW << "," << dilationH << "], " << (padding == CONV_PAD_SAME ? "SAME" : "VALID");
+		if (groups > 1)
+			buffer << ", " << groups << " groups";
+		return buffer.str();
+	}
+};
+
+// conv2DGeometry_t: output size and padding of one layer. Output element (i, j) reads the activation window whose filter 
+// tap (x, y) sits at activation (originW(i) + x * dilationW, originH(j) + y * dilationH); taps outside the activation read 0.
+// With SAME padding, the padding that doesn't split evenly goes to the right/bottom, as in TensorFlow.
+struct conv2DGeometry_t {
+	conv2DParams_t params;
+	int OW, OH;					// output face
+	int padW, padH;				// left/top padding
+
+	conv2DGeometry_t(int W, int H, int KW, int KH, const conv2DParams_t& _params) : params(_params) {
+		int KWe = (KW - 1) * params.dilationW + 1;		// effective (dilated) filter extent
+		int KHe = (KH - 1) * params.dilationH + 1;
+
+		if (params.padding == CONV_PAD_SAME) {
+			OW = (W + params.strideW - 1) / params.strideW;
+			OH = (H + params.strideH - 1) / params.strideH;
+			padW = ((OW - 1) * params.strideW + KWe - W) / 2; if (padW < 0) padW = 0;
+			padH = ((OH - 1) * params.strideH + KHe - H) / 2; if (padH < 0) padH = 0;
+		} else {
+			OW = W < KWe ? 0 : (W - KWe) / params.strideW + 1;
+			OH = H < KHe ? 0 : (H - KHe) / params.strideH + 1;
+			padW = padH = 0;
+		}
+	}
+
+	// activation coordinates of the window origin for output element (i, j)
+	inline int originW(int i) const { return i * params.strideW - padW; }
+	inline int originH(int j) const { return j * params.strideH - padH; }
+};
+
+// convBand_t: output rows [j0, j1) of a layer whose input is H rows high, computed from a tensor that holds only input
+// rows [base, base + its height). Fused layer execution produces each layer's output a band at a time.
+struct convBand_t {
+	int j0, j1;					// output rows
+	int base;					// input row held in row 0 of the tensor
+	int H;						// full input height
+
+	convBand_t(int _j0, int _j1, int _base, int _H) : j0(_j0), j1(_j1), base(_base), H(_H) {}
+};
+
+#endif // _CONV_H_
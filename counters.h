@@ -0,0 +1,124 @@
+/**
+ * @file counters.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief utilization and data movement counters for the simulated HW multiplier.
+ */
+#ifndef _COUNTERS_H_
+#define _COUNTERS_H_
+#include <stdint.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// hwMMcounters_t: counts of what the simulated N x P x P multiplier did for one layer. An invocation with "rows" used 
+// vectors (of N), "cols" used filters (of P) and "depth" used slice elements (of P) does rows * cols * depth useful MACs 
+// out of N * P * P; the rest is idle padding. Loads are counted in bytes as the HW would move them: a vector load fills 
+// one P-wide row of hwMMvectors, a matrix load fills the whole P x P hwMMmatrix. Writebacks are accumulators stored to 
+// the result. Skipped invocations are steps with an all-zero filter tile that the simulator left out (with their loads),
+// see PackedFilters_t. Simulator threads each keep their own counters which are added up at the end of the layer.
+// With several engines (hwMM.engines), the modeled cycles of the layer on them are added too, see modelEngines().
+struct hwMMcounters_t {
+	uint64_t invocations;					// multiplier steps
+	uint64_t rowSlots, rowsUsed;			// N per invocation; vectors actually used
+	uint64_t colSlots, colsUsed;			// P per invocation; filters actually used
+	uint64_t depthSlots, depthUsed;			// P per invocation; slice elements actually used
+	uint64_t macSlots, macsUsed;			// N * P * P per invocation; useful MACs
+	uint64_t vectorBytes;					// bytes loaded into hwMMvectors
+	uint64_t matrixLoads, matrixBytes;		// P x P tiles loaded into hwMMmatrix, and their bytes
+	uint64_t writebacks;					// accumulators stored to the result tensor
+	uint64_t skipped;						// invocations left out for all-zero filter tiles
+	uint64_t engineCycles;					// modeled cycles until the last engine finished
+	uint64_t portCycles;					// modeled cycles the shared load port was busy
+	uint64_t loadCycles;					// modeled cycles engines spent on their loads, waiting for the port included
+	uint64_t stallCycles;					// modeled cycles engines waited for loads before computing
+	std::vector<uint64_t> engineBusy;		// modeled compute cycles of each engine
+
+	hwMMcounters_t() { clear(); }
+
+	// reset all counts
+	void clear() {
+		invocations = rowSlots = rowsUsed = colSlots = colsUsed = depthSlots = depthUsed = macSlots = macsUsed = 0;
+		vectorBytes = matrixLoads = matrixBytes = writebacks = skipped = 0;
+		engineCycles = portCycles = loadCycles = stallCycles = 0;
+		engineBusy.clear();
+	}
+
+	// count one multiplier invocation
+	inline void invoke(int N, int P, int rows, int cols, int depth) { invoke(N, P, rows, cols, depth, cols * depth); }
+
+	// count one invocation of a tile where only "work" of the cols x depth (filter, element) pairs are useful, as in the
+	// block diagonal tiles of a grouped convolution
+	inline void invoke(int N, int P, int rows, int cols, int depth, int work) {
+		invocations++;
+		rowSlots += N; rowsUsed += rows;
+		colSlots += P; colsUsed += cols;
+		depthSlots += P; depthUsed += depth;
+		macSlots += (uint64_t) N * P * P; macsUsed += (uint64_t) rows * work;
+	}
+
+	// count data movement
+	inline void loadVectors(int P, int rows) { vectorBytes += (uint64_t) rows * P; }
+	inline void loadMatrix(int P) { matrixLoads++; matrixBytes += (uint64_t) P * P; }
+	inline void writeback(int count) { writebacks += count; }
+
+	// count invocations left out
+	inline void skip(int count) { skipped += count; }
+
+	// add another set of counters
+	hwMMcounters_t& operator+= (const hwMMcounters_t& c) {
+		invocations += c.invocations;
+		rowSlots += c.rowSlots; rowsUsed += c.rowsUsed;
+		colSlots += c.colSlots; colsUsed += c.colsUsed;
+		depthSlots += c.depthSlots; depthUsed += c.depthUsed;
+		macSlots += c.macSlots; macsUsed += c.macsUsed;
+		vectorBytes += c.vectorBytes;
+		matrixLoads += c.matrixLoads; matrixBytes += c.matrixBytes;
+		writebacks += c.writebacks;
+		skipped += c.skipped;
+		engineCycles += c.engineCycles;
+		portCycles += c.portCycles;
+		loadCycles += c.loadCycles;
+		stallCycles += c.stallCycles;
+		if (engineBusy.size() < c.engineBusy.size())
+			engineBusy.resize(c.engineBusy.size(), 0);
+		for (size_t e = 0; e < c.engineBusy.size(); e++)
+			engineBusy[e] += c.engineBusy[e];
+		return *this;
+	}
+
+	// utilization as a fraction of the slots
+	static double fraction(uint64_t used, uint64_t slots) { return slots ? (double) used / (double) slots : 0.0; }
+	inline double macUtilization() const { return fraction(macsUsed, macSlots); }
+	inline double rowUtilization() const { return fraction(rowsUsed, rowSlots); }
+	inline double colUtilization() const { return fraction(colsUsed, colSlots); }
+	inline double depthUtilization() const { return fraction(depthUsed, depthSlots); }
+	inline double skippedFraction() const { return fraction(skipped, invocations + skipped); }
+	inline double engineUtilization(int e) const { return fraction(engineBusy[e], engineCycles); }
+	inline double portUtilization() const { return fraction(portCycles, engineCycles); }
+	inline double loadOverlap() const { return loadCycles > stallCycles ? fraction(loadCycles - stallCycles, loadCycles) : 0.0; }
+
+	// bytes loaded per invocation
+	inline double bytesPerInvocation() const { return invocations ? (double) (vectorBytes + matrixBytes) / (double) invocations : 0.0; }
+
+	// generate a string with a report
+	std::string operator() () const {
+		std::ostringstream buffer;
+		buffer.precision(3);
+		buffer << invocations << " MM invocations, " << 100.0 * macUtilization() << "% MAC utilization (rows " << 100.0 * rowUtilization() << 
+				"%, columns " << 100.0 * colUtilization() << "%, depth " << 100.0 * depthUtilization() << "%), " << vectorBytes << " vector bytes, " << 
+				matrixBytes << " matrix bytes in " << matrixLoads << " tiles, " << bytesPerInvocation() << " bytes/invocation, " << writebacks << " writebacks";
+		if (skipped)
+			buffer << ", " << skipped << " invocations skipped (" << 100.0 * skippedFraction() << "% of dense)";
+		if (!engineBusy.empty()) {
+			buffer << ", " << engineBusy.size() << " engines: " << engineCycles << " cycles, utilization";
+			for (size_t e = 0; e < engineBusy.size(); e++)
+				buffer << " " << 100.0 * engineUtilization(e) << "%";
+			buffer << ", load port " << 100.0 * portUtilization() << "% busy, " << stallCycles << " cycles stalled on loads (" << 
+					100.0 * loadOverlap() << "% of load cycles overlapped with compute)";
+		}
+		return buffer.str();
+	}
+};
+
+#endif // _COUNTERS_H_
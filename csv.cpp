@@ -0,0 +1,125 @@
+/**
+ * @file csv.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief buffered CSV text writer for tensor dumps.
+ */
+#include <string.h>
+#include <string>
+#include "csv.h"
+
+const char CsvWriter_t::digitPairs[201] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+// Constructors
+CsvWriter_t::CsvWriter_t(std::ostream& _os, bool async, size_t bufferSize) : os(&_os), fp(NULL), pipe(false), precision(_os.precision()) {
+	start(bufferSize, async);
+}
+
+CsvWriter_t::CsvWriter_t(const char *path, bool async, size_t bufferSize) : os(NULL), fp(NULL), pipe(false), precision(6) {
+	size_t len = strlen(path);
+	if (len > 3 && !strcmp(path + len - 3, ".gz")) {
+		// gzip -c > 'path', with quotes in the name escaped for the shell
+		std::string command = "gzip -c > '";
+		for (const char *p = path; *p; p++)
+			if (*p == '\'')
+				command += "'\\''";
+			else
+				command += *p;
+		command += "'";
+		fp = popen(command.c_str(), "w");
+		pipe = true;
+	} else
+		fp = fopen(path, "w");
+	start(bufferSize, async);
+}
+
+// set up the buffers and the background writer
+void CsvWriter_t::start(size_t bufferSize, bool _async) {
+	if (precision < 1)
+		precision = 1;
+	integralLimit = pow(10.0, precision < 18 ? precision : 18);
+	buffer.resize(bufferSize < 64 ? 64 : bufferSize);
+	cur = buffer.data();
+	end = cur + buffer.size();
+	async = _async && ok();
+	pendingBytes = 0;
+	done = false;
+	if (async) {
+		pending.resize(buffer.size());
+		writer = std::thread(&CsvWriter_t::writerLoop, this);
+	}
+}
+
+// Destructor
+CsvWriter_t::~CsvWriter_t() {
+	flush();
+	if (async) {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			done = true;
+		}
+		cond.notify_all();
+		writer.join();
+	}
+	if (fp) {
+		if (pipe)
+			pclose(fp);
+		else
+			fclose(fp);
+	}
+}
+
+// write to the sink
+void CsvWriter_t::write(const char *data, size_t bytes) {
+	if (os)
+		os->write(data, bytes);
+	else if (fp)
+		fwrite(data, 1, bytes, fp);
+}
+
+// hand the formatted text to the writer (waiting until it took the previous buffer), or write it now
+void CsvWriter_t::drain() {
+	size_t bytes = cur - buffer.data();
+	if (bytes && async) {
+		std::unique_lock<std::mutex> guard(lock);
+		cond.wait(guard, [this] { return pendingBytes == 0; });
+		pending.swap(buffer);
+		pendingBytes = bytes;
+		guard.unlock();
+		cond.notify_all();
+	} else if (bytes)
+		write(buffer.data(), bytes);
+	cur = buffer.data();
+	end = cur + buffer.size();
+}
+
+// write out everything formatted so far
+void CsvWriter_t::flush() {
+	drain();
+	if (async) {
+		std::unique_lock<std::mutex> guard(lock);
+		cond.wait(guard, [this] { return pendingBytes == 0; });
+	}
+	if (os)
+		os->flush();
+	else if (fp)
+		fflush(fp);
+}
+
+// background writer: write each handed over buffer
+void CsvWriter_t::writerLoop() {
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;) {
+		cond.wait(guard, [this] { return pendingBytes != 0 || done; });
+		if (pendingBytes == 0)
+			return;
+		guard.unlock();
+		write(pending.data(), pendingBytes);
+		guard.lock();
+		pendingBytes = 0;
+		cond.notify_all();
+	}
+}
@@ -0,0 +1,110 @@
+/**
+ * @file csv.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief buffered CSV text writer for tensor dumps.
+ */
+#ifndef _CSV_H_
+#define _CSV_H_
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// CsvWriter_t class
+// Formats text into a large buffer and writes it out in bulk: integers two digits at a time, floats as an ostream of the same
+// precision would ("%.<precision>g", with integral values formatted as integers). The sink is an ostream or a file; a file
+// name ending in ".gz" is written through gzip. With "async", full buffers are written by a background thread while
+// formatting continues in a second buffer, so a dump streams out while the caller goes on producing results.
+// Everything is written by the time flush() returns or the writer is destroyed.
+class CsvWriter_t {
+public:
+	// Constructors: write to "os" (with its precision), or create the file "path" (check ok())
+	CsvWriter_t(std::ostream& os, bool async = false, size_t bufferSize = 1 << 20);
+	CsvWriter_t(const char *path, bool async = false, size_t bufferSize = 1 << 20);
+
+	// Destructor
+	virtual ~CsvWriter_t();
+
+	// true if the sink is open
+	inline bool ok() const { return os != NULL || fp != NULL; }
+
+	// text
+	inline void put(char c) { reserve(1); *cur++ = c; }
+	inline void put(const char *s) { while (*s) put(*s++); }
+
+	// numbers
+	inline void put(int64_t v) {
+		char digits[24], *p = digits + sizeof(digits);
+		uint64_t u = v < 0 ? 0 - (uint64_t) v : (uint64_t) v;
+		reserve(sizeof(digits));
+		if (v < 0)
+			*cur++ = '-';
+		while (u >= 100) {								// two digits at a time
+			p -= 2;
+			memcpy(p, &digitPairs[2 * (u % 100)], 2);
+			u /= 100;
+		}
+		if (u >= 10) {
+			p -= 2;
+			memcpy(p, &digitPairs[2 * u], 2);
+		} else
+			*--p = '0' + u;
+		memcpy(cur, p, digits + sizeof(digits) - p);
+		cur += digits + sizeof(digits) - p;
+	}
+	inline void put(int v) { put((int64_t) v); }
+	inline void put(double v) {
+		if (isfinite(v) && fabs(v) < integralLimit && v == (double) (int64_t) v && (v != 0.0 || !signbit(v)))
+			put((int64_t) v);
+		else {
+			reserve(32);
+			cur += snprintf(cur, 32, "%.*g", precision, v);
+		}
+	}
+	inline void put(float v) { put((double) v); }
+
+	// end a line
+	inline void endl() { put('\n'); }
+
+	// write out everything formatted so far
+	void flush();
+
+private:
+	static const char digitPairs[201];	// "00" .. "99"
+	std::ostream *os;
+	FILE *fp;
+	bool pipe;							// "fp" came from popen()
+	int precision;						// significant digits of non-integral floats
+	double integralLimit;				// integral floats below this print as integers under "%.<precision>g"
+	std::vector<char> buffer;			// being formatted
+	char *cur, *end;
+
+	// background writer
+	bool async;
+	std::thread writer;
+	std::mutex lock;
+	std::condition_variable cond;
+	std::vector<char> pending;			// full buffer handed to the writer
+	size_t pendingBytes;
+	bool done;
+
+	// make room for n more characters
+	inline void reserve(size_t n) { if ((size_t) (end - cur) < n) drain(); }
+
+	void start(size_t bufferSize, bool _async);
+	void drain();
+	void write(const char *data, size_t bytes);
+	void writerLoop();
+
+	// no copies
+	CsvWriter_t(const CsvWriter_t&);
+	CsvWriter_t& operator= (const CsvWriter_t&);
+};
+
+#endif // _CSV_H_
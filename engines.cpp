@@ -0,0 +1,109 @@
+/**
+ * @file engines.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief several simulated HW multiplier engines sharing one load port.
+ */
+#include <algorithm>
+#include "engines.h"
+
+// run the units on the engines, or on the host threads
+void runOnEngines(const TileScheduler_t& scheduler, int engines, int units, const std::function<void(int, int)>& fn) {
+	if (engines <= 0) {
+		scheduler.run(units, fn);
+		return;
+	}
+	scheduler.run(engines, [&](int e, int) {
+		for (int u = (int) ((long) e * units / engines); u < (int) ((long) (e + 1) * units / engines); u++)
+			fn(u, e);
+	});
+}
+
+// run the units in two stages on the engines, or on the host threads
+void runOnEngines(const TileScheduler_t& scheduler, int engines, int units, const std::function<void(int, int, int)>& produce, 
+		const std::function<void(int, int, int)>& consume) {
+	if (engines <= 0) {
+		scheduler.run(units, produce, consume);
+		return;
+	}
+	bool serial = TileScheduler_t::nested();
+	scheduler.run(engines, [&](int e, int) {
+		int u = (int) ((long) e * units / engines), end = (int) ((long) (e + 1) * units / engines);
+		TileScheduler_t::pipeline([&](int& unit) {
+			if (u >= end)
+				return false;
+			unit = u++;
+			return true;
+		}, e, serial, produce, consume);
+	});
+}
+
+// per engine replay state
+struct engineState_t {
+	size_t next;				// next step
+	uint64_t loadDone;			// cycle the last load finished
+	uint64_t computeDone;		// cycle the last step finished computing
+	uint64_t priorDone;			// cycle the step before that finished computing (its operand buffer is then free)
+	uint64_t busy;				// compute cycles
+	uint64_t load;				// cycles from a load being ready to issue until it finished, waiting for the port included
+	uint64_t stall;				// cycles compute waited for a load
+};
+
+// replay the traces
+void modelEngines(const std::vector<const EngineTrace_t *>& traces, int loadBytes, int buffers, hwMMcounters_t& counters) {
+	int E = traces.size();
+	std::vector<engineState_t> engine(E, engineState_t());
+	uint64_t portFree = 0, portBusy = 0, load = 0, stall = 0, makespan = 0;
+
+	if (loadBytes < 1)
+		loadBytes = 1;
+	for (;;) {
+		// the engine whose next load can start first gets the port
+		int e = -1;
+		uint64_t ready = 0;
+		for (int f = 0; f < E; f++) {
+			const engineState_t& s = engine[f];
+			if (s.next == traces[f]->steps().size())
+				continue;
+			uint64_t r = std::max(s.loadDone, buffers > 1 ? s.priorDone : s.computeDone);
+			if (e < 0 || r < ready) {
+				e = f;
+				ready = r;
+			}
+		}
+		if (e < 0)
+			break;
+
+		// load, then compute once the previous step is done
+		engineState_t& s = engine[e];
+		const engineStep_t& step = traces[e]->steps()[s.next++];
+		uint64_t loadDone = ready;
+		if (step.bytes) {
+			uint64_t start = std::max(ready, portFree);
+			uint64_t cycles = (step.bytes + loadBytes - 1) / loadBytes;
+			loadDone = portFree = start + cycles;
+			portBusy += cycles;
+		}
+		s.load += loadDone - ready;
+		s.loadDone = loadDone;
+		s.priorDone = s.computeDone;
+		s.stall += loadDone > s.computeDone ? loadDone - s.computeDone : 0;
+		s.computeDone = std::max(loadDone, s.computeDone) + step.cycles;
+		s.busy += step.cycles;
+		makespan = std::max(makespan, s.computeDone);
+	}
+
+	// add to the counters
+	counters.engineCycles += makespan;
+	counters.portCycles += portBusy;
+	for (int e = 0; e < E; e++) {
+		load += engine[e].load;
+		stall += engine[e].stall;
+	}
+	counters.loadCycles += load;
+	counters.stallCycles += stall;
+	if ((int) counters.engineBusy.size() < E)
+		counters.engineBusy.resize(E, 0);
+	for (int e = 0; e < E; e++)
+		counters.engineBusy[e] += engine[e].busy;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file engines.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief several simulated HW multiplier engines sharing one load port.
+ */
+#ifndef _ENGINES_H_
+#define _ENGINES_H_
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include "counters.h"
+#include "scheduler.h"
+
+// With hwMM.engines > 0, a layer runs on that many N x P x P multiplier engines. The simulation units of the layer (see
+// simulatedConv2D()) are dealt out to the engines in contiguous blocks, like the HW would split its channel and surface tiles,
+// and each engine runs its block in order on a host thread of its own (as far as option_threads allows). Every engine records
+// its multiplier steps in an EngineTrace_t; once the layer is done, modelEngines() replays the traces against the load port
+// the engines share, which yields the cycles the layer takes and how busy each engine was. The model only depends on the
+// traces, so it is the same for any host thread count.
+
+// one multiplier step of an engine
+struct engineStep_t {
+	uint32_t bytes;				// vector and matrix bytes loaded for the step through the shared load port
+	uint32_t cycles;			// compute cycles of the step
+};
+
+// compute cycles of one invocation: the N vectors stream through the P x P array one per cycle
+inline int engineStepCycles(int N) { return N; }
+
+// EngineTrace_t class
+// The steps of one engine in program order. step() is called after an invocation was counted in the engine's counters;
+// the step's bytes are those loaded since the previous step.
+class EngineTrace_t {
+public:
+	EngineTrace_t() : loaded(0) {}
+
+	// record a step
+	inline void step(const hwMMcounters_t& count, int cycles) {
+		uint64_t bytes = count.vectorBytes + count.matrixBytes;
+		engineStep_t s = { (uint32_t) (bytes - loaded), (uint32_t) cycles };
+		trace.push_back(s);
+		loaded = bytes;
+	}
+
+	// accessors
+	inline const std::vector<engineStep_t>& steps() const { return trace; }
+
+private:
+	std::vector<engineStep_t> trace;
+	uint64_t loaded;			// bytes counted up to the last step
+};
+
+// runOnEngines: run "units" work units; with "engines" > 0, engine e runs units [e * units / engines, (e + 1) * units / engines)
+// in order, and fn(unit, slot) gets the engine as slot. Otherwise the units are spread over the host threads of "scheduler"
+// and the slot is the thread. engineSlots() is the number of slots, for per-slot state. The second form runs each unit in 
+// two stages, produce(unit, slot, buffer) and consume(unit, slot, buffer), pipelined per slot (see TileScheduler_t).
+extern void runOnEngines(const TileScheduler_t& scheduler, int engines, int units, const std::function<void(int, int)>& fn);
+extern void runOnEngines(const TileScheduler_t& scheduler, int engines, int units, const std::function<void(int, int, int)>& produce, 
+		const std::function<void(int, int, int)>& consume);
+inline int engineSlots(const TileScheduler_t& scheduler, int engines) { return engines > 0 ? engines : scheduler.threadCount(); }
+
+// modelEngines: replay the engine traces against a load port moving "loadBytes" bytes per cycle and add the cycles to
+// "counters" (engineCycles, portCycles, loadCycles, stallCycles, engineBusy). Each engine holds the operands of "buffers" 
+// steps: with one, a step's load waits until the step before has finished computing, so loads and compute alternate; with
+// two (double buffering), the next step loads while the current one computes, and a load may start once the step before 
+// the current one has finished computing. The port serves one load at a time, first come first served (the lower engine 
+// first on a tie). loadCycles and stallCycles are both summed over the engines, so hwMMcounters_t::loadOverlap() is the 
+// share of the engines' load time, port waits included, hidden under their compute.
+extern void modelEngines(const std::vector<const EngineTrace_t *>& traces, int loadBytes, int buffers, hwMMcounters_t& counters);
+
+#endif // _ENGINES_H_
@@ -0,0 +1,226 @@
+/**
+ * @file epilogue.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief accumulator models and the writeback epilogue of the simulated HW multiplier.
+ */
+#include <math.h>
+#include <immintrin.h>
+#include "epilogue.h"
+
+// Constructor
+hwMMepilogue_t::hwMMepilogue_t(int _accum, int C) : accum(_accum), activation(HWMM_ACT_NONE), lo(-128), hi(127) {
+	for (int c = 0; c < C; c++)
+		setMultiplier(c, 1.0);
+}
+
+// size the per channel arrays; new channels get no bias
+void hwMMepilogue_t::resize(int C) {
+	bias.resize(C, 0);
+	scale.resize(C);
+	shift.resize(C);
+	scaleD.resize(C);
+	halfD.resize(C);
+	unitD.resize(C);
+}
+
+// set the activation function
+void hwMMepilogue_t::setActivation(int act, int clampLo, int clampHi) {
+	activation = act;
+	switch (act) {
+		case HWMM_ACT_RELU:
+			lo = 0;
+			hi = 127;
+			break;
+		case HWMM_ACT_RELU6:
+			lo = 0;
+			hi = hwMMrelu6Max;
+			break;
+		case HWMM_ACT_CLAMP:
+			lo = clampLo < -128 ? -128 : clampLo;
+			hi = clampHi > 127 ? 127 : clampHi;
+			break;
+		default:
+			activation = HWMM_ACT_NONE;
+			lo = -128;
+			hi = 127;
+			break;
+	}
+}
+
+// calibrate per channel multipliers: the sum of channel c has variance M(M+1)/3 * sum(w^2) for activations uniform in [-M, M]
+hwMMepilogue_t hwMMepilogue_t::calibrate(int accum, const TensorArray_t<int8_t>& filtSet, int maxInt) {
+	hwMMepilogue_t epi(accum);
+	const int8_t *w = filtSet.buffer();
+
+	for (int c = 0; c < filtSet.count(); c++) {
+		double energy = 0.0;
+		for (int l = 0; l < filtSet.length(); l++)
+			energy += (double) w[c * filtSet.stride() + l] * w[c * filtSet.stride() + l];
+		double sigma = sqrt(maxInt * (maxInt + 1.0) / 3.0 * energy);
+		epi.setMultiplier(c, sigma > 0.0 ? 127.0 / (4.0 * sigma) : 1.0);
+	}
+	return epi;
+}
+
+// set the multiplier of channel c
+void hwMMepilogue_t::setMultiplier(int c, double multiplier) {
+	int e, s;
+	double f = frexp(multiplier, &e);					// multiplier = f * 2^e, f in [0.5, 1)
+	int32_t m = (int32_t) lround(f * 32768.0);
+	if (m == 32768) {
+		m = 16384;
+		e++;
+	}
+	s = 15 - e;
+	if (s < 1) {										// too large to represent; saturate
+		s = 1;
+		m = 32767;
+	} else if (s > 40) {								// too small; keep the shift in range of the exact vector code
+		s = 40;
+		m = (int32_t) lround(ldexp(multiplier, 40));
+	}
+
+	if ((int) scale.size() <= c)
+		resize(c + 1);
+	scale[c] = m;
+	shift[c] = s;
+	scaleD[c] = m;
+	halfD[c] = ldexp(1.0, s - 1);
+	unitD[c] = ldexp(1.0, -s);
+}
+
+// name of the accumulator model
+const char *hwMMepilogue_t::name() const {
+	switch (accum) {
+		case HWMM_ACC_SAT8:
+			return "sat8";
+		case HWMM_ACC_WIDE16:
+			return "wide16";
+		case HWMM_ACC_WIDE32:
+			return "wide32";
+		default:
+			return "wrap8";
+	}
+}
+
+// name of the activation function
+const char *hwMMepilogue_t::activationName() const {
+	switch (activation) {
+		case HWMM_ACT_RELU:
+			return "relu";
+		case HWMM_ACT_RELU6:
+			return "relu6";
+		case HWMM_ACT_CLAMP:
+			return "clamp";
+		default:
+			return "none";
+	}
+}
+
+// scalar epilogue
+static void storeScalar(const hwMMepilogue_t& epi, int8_t *out, const int32_t *acc, int rows, int P, int c0, int cols) {
+	for (int n = 0; n < rows; n++)
+		for (int i = 0; i < cols; i++)
+			out[n * P + i] = epi.apply(acc[n * P + i], c0 + i);
+}
+
+// store the low byte of each 32-bit lane
+__attribute__((target("avx2")))
+static inline void storeLowBytes(int8_t *out, __m256i v) {
+	const __m256i pick = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	__m256i b = _mm256_shuffle_epi8(v, pick);
+	_mm_storel_epi64((__m128i *) out, _mm_unpacklo_epi32(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1)));
+}
+
+// requantize 8 lanes of channels c .. c + 7 and clamp them to [lo, hi]. In double precision every step is exact: |v * scale| < 2^47,
+// the rounding term and the power of 2 scaling don't lose bits, and floor() is the arithmetic shift of the scalar code.
+__attribute__((target("avx2")))
+static inline __m256i requantize8(const hwMMepilogue_t& epi, __m256i v, int c) {
+	const __m256d lo = _mm256_set1_pd(epi.lo), hi = _mm256_set1_pd(epi.hi);
+	__m256d s0 = _mm256_loadu_pd(&epi.scaleD[c]), s1 = _mm256_loadu_pd(&epi.scaleD[c + 4]);
+	__m256d h0 = _mm256_loadu_pd(&epi.halfD[c]), h1 = _mm256_loadu_pd(&epi.halfD[c + 4]);
+	__m256d u0 = _mm256_loadu_pd(&epi.unitD[c]), u1 = _mm256_loadu_pd(&epi.unitD[c + 4]);
+	__m256d d0 = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+	__m256d d1 = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+	d0 = _mm256_floor_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(d0, s0), h0), u0));
+	d1 = _mm256_floor_pd(_mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(d1, s1), h1), u1));
+	d0 = _mm256_min_pd(_mm256_max_pd(d0, lo), hi);
+	d1 = _mm256_min_pd(_mm256_max_pd(d1, lo), hi);
+	return _mm256_set_m128i(_mm256_cvttpd_epi32(d1), _mm256_cvttpd_epi32(d0));
+}
+
+// AVX2 epilogue: 8 channels of a row at a time (bias, accumulator model, requantization and activation in registers),
+// scalar for the rest of the row
+__attribute__((target("avx2")))
+static void storeAVX2(const hwMMepilogue_t& epi, int8_t *out, const int32_t *acc, int rows, int P, int c0, int cols) {
+	const __m256i lo = _mm256_set1_epi32(epi.lo), hi = _mm256_set1_epi32(epi.hi);
+	for (int n = 0; n < rows; n++) {
+		const int32_t *a = &acc[n * P];
+		int8_t *o = &out[n * P];
+		int i = 0;
+		for (; i + 8 <= cols; i += 8) {
+			__m256i v = _mm256_loadu_si256((const __m256i *) &a[i]);
+			__m256i b = _mm256_loadu_si256((const __m256i *) &epi.bias[c0 + i]);
+			switch (epi.accum) {
+				case HWMM_ACC_WRAP8:
+					v = _mm256_add_epi32(v, b);
+					v = _mm256_srai_epi32(_mm256_slli_epi32(v, 24), 24);
+					v = _mm256_min_epi32(_mm256_max_epi32(v, lo), hi);
+					break;
+				case HWMM_ACC_SAT8:
+					v = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(v, b), lo), hi);
+					break;
+				case HWMM_ACC_WIDE16:
+					v = requantize8(epi, _mm256_add_epi32(_mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16), b), c0 + i);
+					break;
+				default:
+					v = requantize8(epi, _mm256_add_epi32(v, b), c0 + i);
+					break;
+			}
+			storeLowBytes(&o[i], v);
+		}
+		for (; i < cols; i++)
+			o[i] = epi.apply(a[i], c0 + i);
+	}
+}
+
+// writeback
+void hwMMepilogue_t::store(int8_t *out, const int32_t *acc, int rows, int P, int c0, int cols) const {
+	static const bool avx2 = __builtin_cpu_supports("avx2");
+	if (avx2)
+		storeAVX2(*this, out, acc, rows, P, c0, cols);
+	else
+		storeScalar(*this, out, acc, rows, P, c0, cols);
+}
+
+// 8-bit saturating accumulate
+__attribute__((target("avx2")))
+static void saturateAVX2(int32_t *acc, const int32_t *partial, int n) {
+	const __m256i lo = _mm256_set1_epi32(-128), hi = _mm256_set1_epi32(127);
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) &acc[i]), _mm256_loadu_si256((const __m256i *) &partial[i]));
+		_mm256_storeu_si256((__m256i *) &acc[i], _mm256_min_epi32(_mm256_max_epi32(v, lo), hi));
+	}
+	for (; i < n; i++) {
+		int32_t v = acc[i] + partial[i];
+		acc[i] = v < -128 ? -128 : (v > 127 ? 127 : v);
+	}
+}
+
+static void saturateScalar(int32_t *acc, const int32_t *partial, int n) {
+	for (int i = 0; i < n; i++) {
+		int32_t v = acc[i] + partial[i];
+		acc[i] = v < -128 ? -128 : (v > 127 ? 127 : v);
+	}
+}
+
+void hwMMsaturate(int32_t *acc, const int32_t *partial, int n) {
+	static const bool avx2 = __builtin_cpu_supports("avx2");
+	if (avx2)
+		saturateAVX2(acc, partial, n);
+	else
+		saturateScalar(acc, partial, n);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file epilogue.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief accumulator models and the writeback epilogue of the simulated HW multiplier.
+ */
+#ifndef _EPILOGUE_H_
+#define _EPILOGUE_H_
+#include <stdint.h>
+#include <vector>
+#include "tensor.h"
+
+// accumulator models (option_accum)
+enum hwMMaccum_t {
+	HWMM_ACC_WRAP8 = 0,			// 8-bit accumulators that wrap around on overflow
+	HWMM_ACC_SAT8 = 1,			// 8-bit accumulators that saturate; each multiplier step adds its P-term dot products and clamps
+	HWMM_ACC_WIDE16 = 2,		// 16-bit (wrapping) accumulators, requantized to 8 bits on writeback
+	HWMM_ACC_WIDE32 = 3			// 32-bit accumulators, requantized to 8 bits on writeback
+};
+
+// activation functions applied to the 8-bit outputs (option_activation)
+enum hwMMactivation_t {
+	HWMM_ACT_NONE = 0,
+	HWMM_ACT_RELU = 1,			// max(x, 0)
+	HWMM_ACT_RELU6 = 2,			// min(max(x, 0), 6.0); outputs are taken as Q3.4 fixed point, so 6.0 is hwMMrelu6Max
+	HWMM_ACT_CLAMP = 3			// clamp to a given [lo, hi]
+};
+static const int hwMMrelu6Max = 6 << 4;
+
+// hwMMepilogue_t: how the accumulators of one layer turn into its 8-bit outputs.
+// The simulator keeps every accumulator as an int32 holding the exact sum (or, for HWMM_ACC_SAT8, the saturated running sum),
+// which is bit for bit what the narrower HW accumulators hold once truncated. On writeback, accumulator a of output channel c
+// becomes apply(a, c) = activate(o) with
+//
+//		WRAP8:	o = (int8_t) (a + bias[c])
+//		SAT8:	o = clamp(a + bias[c], -128, 127)
+//		WIDE16:	o = requantize((int16_t) a + bias[c], c)
+//		WIDE32:	o = requantize(a + bias[c], c)
+//
+// where requantize(v, c) = clamp((v * scale[c] + 2^(shift[c] - 1)) >> shift[c], -128, 127), i.e. v times scale[c] / 2^shift[c],
+// rounded half up, and activate() clamps to [lo, hi] per the activation function. The bias is in accumulator units.
+// store() does all of it in one pass over an accumulator tile with SIMD code picked for the CPU.
+struct hwMMepilogue_t {
+	int accum;								// hwMMaccum_t
+	int activation;							// hwMMactivation_t
+	int32_t lo, hi;							// output range after the activation
+	std::vector<int32_t> bias;				// per output channel bias
+	std::vector<int32_t> scale;				// per output channel requantization multiplier, normally in [2^14, 2^15)
+	std::vector<int32_t> shift;				// per output channel requantization shift, >= 1
+	std::vector<double> scaleD, halfD, unitD;	// scale[c], 2^(shift[c] - 1) and 2^-shift[c] as doubles, for the vector code
+
+	// Constructor: "C" output channels, all with no bias and multiplier 1 (the requantizing modes then only saturate),
+	// and no activation
+	hwMMepilogue_t(int _accum = HWMM_ACC_WRAP8, int C = 0);
+
+	// calibrated epilogue for a filter set whose activations are uniform in [-maxInt, maxInt]: channel c is scaled so that
+	// 4 standard deviations of its sums map to 127
+	static hwMMepilogue_t calibrate(int accum, const TensorArray_t<int8_t>& filtSet, int maxInt);
+
+	// set the multiplier of channel c to the nearest scale / 2^shift
+	void setMultiplier(int c, double multiplier);
+
+	// set the bias of channel c
+	inline void setBias(int c, int32_t b) { bias[c] = b; }
+
+	// set the activation function; "clampLo" and "clampHi" are only used for HWMM_ACT_CLAMP
+	void setActivation(int act, int clampLo = -128, int clampHi = 127);
+
+	// true if writeback requantizes
+	inline bool requantizes() const { return accum == HWMM_ACC_WIDE16 || accum == HWMM_ACC_WIDE32; }
+
+	// the 8-bit output for accumulator "a" of channel c
+	inline int8_t apply(int32_t a, int c) const {
+		int64_t v;
+		switch (accum) {
+			case HWMM_ACC_WRAP8:
+				v = (int8_t) (a + bias[c]);
+				break;
+			case HWMM_ACC_SAT8:
+				v = (int64_t) a + bias[c];
+				break;
+			default:
+				v = (int64_t) (accum == HWMM_ACC_WIDE16 ? (int16_t) a : a) + bias[c];
+				v = (v * scale[c] + ((int64_t) 1 << (shift[c] - 1))) >> shift[c];
+				break;
+		}
+		return v < lo ? lo : (v > hi ? hi : (int8_t) v);
+	}
+
+	// the output a perfect (unbounded, unrounded) implementation would produce for the exact sum "exact" of channel c;
+	// this is what rms errors are measured against
+	inline double ideal(double exact, int c) const { 
+		double v = exact + bias[c];
+		if (requantizes())
+			v *= scaleD[c] * unitD[c];
+		if (activation != HWMM_ACT_NONE)
+			v = v < lo ? lo : (v > hi ? hi : v);
+		return v;
+	}
+
+	// writeback: out[n * P + i] = apply(acc[n * P + i], c0 + i) for n < rows, i < cols (row stride P in both)
+	void store(int8_t *out, const int32_t *acc, int rows, int P, int c0, int cols) const;
+
+	// names of the accumulator model and activation function
+	const char *name() const;
+	const char *activationName() const;
+
+private:
+	// size the per channel arrays for C channels
+	void resize(int C);
+};
+
+// 8-bit saturating accumulate of one multiplier step: acc[i] = clamp(acc[i] + partial[i], -128, 127)
+extern void hwMMsaturate(int32_t *acc, const int32_t *partial, int n);
+
+#endif // _EPILOGUE_H_
@@ -0,0 +1,299 @@
+/**
+ * @file hwmm.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief simulated HW multiplier kernels.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <immintrin.h>
+#include "hwmm.h"
+
+// per-thread scratch space for re-laid-out operand tiles
+template <typename T>
+static T *kernelScratch(size_t len) {
+	static thread_local std::vector<T> scratch;
+	if (scratch.size() < len)
+		scratch.resize(len);
+	return scratch.data();
+}
+
+// hwMMkernelScalar: reference kernel; one int dot product per output
+static void hwMMkernelScalar(int32_t *res, const int8_t *vecs, const int8_t *mat, int N, int P) {
+	for (int n = 0; n < N; n++) {
+		const int8_t *v = &vecs[n * P];
+		for (int p = 0; p < P; p++) {
+			const int8_t *m = &mat[p * P];
+			int32_t sum = 0;
+			for (int q = 0; q < P; q++)
+				sum += v[q] * m[q];
+			res[n * P + p] += sum;
+		}
+	}
+}
+
+// hwMMkernelAVX2: vectorize across the P outputs of each vector, 8 per register. The tile is sign extended to 16 bits and
+// re-laid out once per call so that each 32-bit lane p holds the elements (2g, 2g + 1) of row p; VPMADDWD against the 
+// matching broadcast pair of input elements then adds two exact products into each 32-bit lane.
+__attribute__((target("avx2")))
+static void hwMMkernelAVX2(int32_t *res, const int8_t *vecs, const int8_t *mat, int N, int P) {
+	int PG = (P + 1) >> 1;								// element pairs per row
+	int PV = (P + 7) & ~7;								// outputs rounded up to whole registers
+	int16_t *matW = kernelScratch<int16_t>(PG * PV * 2 + PG * 2);
+	int16_t *vpad = &matW[PG * PV * 2];
+	int32_t lanes[8];
+
+	// re-lay tile: matW[g][p][r] = mat[p][2g + r], zero padded
+	memset(matW, 0, (PG * PV * 2 + PG * 2) * sizeof(int16_t));
+	for (int p = 0; p < P; p++)
+		for (int q = 0; q < P; q++)
+			matW[((q >> 1) * PV + p) * 2 + (q & 1)] = mat[p * P + q];
+
+	for (int n = 0; n < N; n++) {
+		int32_t *r = &res[n * P];
+		for (int q = 0; q < P; q++)
+			vpad[q] = vecs[n * P + q];
+		for (int p0 = 0; p0 < P; p0 += 8) {
+			__m256i acc = _mm256_setzero_si256();
+			for (int g = 0; g < PG; g++) {
+				int32_t pair;
+				memcpy(&pair, &vpad[g * 2], sizeof(pair));
+				acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_set1_epi32(pair), _mm256_loadu_si256((const __m256i *) &matW[(g * PV + p0) * 2])));
+			}
+			int cnt = P - p0;
+			if (cnt >= 8)
+				_mm256_storeu_si256((__m256i *) &r[p0], _mm256_add_epi32(acc, _mm256_loadu_si256((const __m256i *) &r[p0])));
+			else {
+				_mm256_storeu_si256((__m256i *) lanes, acc);
+				for (int i = 0; i < cnt; i++)
+					r[p0 + i] += lanes[i];
+			}
+		}
+	}
+}
+
+// hwMMkernelAVX512VNNI: VPDPBUSD multiplies 4 adjacent unsigned x signed byte pairs and adds them into a 32-bit lane. 
+// The signed input bytes are biased by 128 to make them unsigned, which adds 128 * (sum of row p) to lane p; that is
+// subtracted up front, so the sums are exact. The tile is re-laid out once per call so that each 32-bit lane p holds 4 
+// consecutive elements of row p; the matching 4 input elements are broadcast to all lanes.
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+static void hwMMkernelAVX512VNNI(int32_t *res, const int8_t *vecs, const int8_t *mat, int N, int P) {
+	int PQ = (P + 3) & ~3;								// dot product length rounded up to whole lane groups
+	int PV = (P + 15) & ~15;							// outputs rounded up to whole registers
+	int8_t *matV = kernelScratch<int8_t>(PQ * PV + PQ + PV * sizeof(int32_t));
+	uint8_t *vpad = (uint8_t *) &matV[PQ * PV];
+	int32_t *bias = (int32_t *) &matV[PQ * PV + PQ];
+	int32_t lanes[16];
+
+	// re-lay tile: matV[g][p][r] = mat[p][4g + r], zero padded; bias[p] = -128 * sum of row p
+	memset(matV, 0, PQ * PV + PQ + PV * sizeof(int32_t));
+	for (int p = 0; p < P; p++) {
+		int32_t sum = 0;
+		for (int q = 0; q < P; q++) {
+			matV[((q >> 2) * PV + p) * 4 + (q & 3)] = mat[p * P + q];
+			sum += mat[p * P + q];
+		}
+		bias[p] = -128 * sum;
+	}
+
+	for (int n = 0; n < N; n++) {
+		int32_t *r = &res[n * P];
+		for (int q = 0; q < P; q++)
+			vpad[q] = (uint8_t) (vecs[n * P + q] + 128);
+		for (int p0 = 0; p0 < P; p0 += 16) {
+			__m512i acc = _mm512_loadu_si512((const void *) &bias[p0]);
+			for (int g = 0; g < PQ / 4; g++) {
+				int32_t quad;
+				memcpy(&quad, &vpad[g * 4], sizeof(quad));
+				acc = _mm512_dpbusd_epi32(acc, _mm512_set1_epi32(quad), _mm512_loadu_si512((const void *) &matV[(g * PV + p0) * 4]));
+			}
+			int cnt = P - p0;
+			if (cnt >= 16)
+				_mm512_storeu_si512((void *) &r[p0], _mm512_add_epi32(acc, _mm512_loadu_si512((const void *) &r[p0])));
+			else {
+				_mm512_storeu_si512((void *) lanes, acc);
+				for (int i = 0; i < cnt; i++)
+					r[p0 + i] += lanes[i];
+			}
+		}
+	}
+}
+
+// Kernels specialized for one tile size P (hwMMfixedSizes): the loop bounds are compile time constants, the re-laid-out
+// tile lives in a fixed-size buffer on the stack, the inner products are fully unrolled and the accumulators of all P 
+// outputs of a vector stay in registers. They compute exactly what the generic kernels above do; the "P" argument is ignored.
+static const int hwMMfixedSizes[] = { 8, 16, 32 };
+
+// hwMMkernelScalarFixed: scalar kernel with constant bounds
+template <int P>
+static void hwMMkernelScalarFixed(int32_t *res, const int8_t *vecs, const int8_t *mat, int N, int) {
+	for (int n = 0; n < N; n++) {
+		const int8_t *v = &vecs[n * P];
+		for (int p = 0; p < P; p++) {
+			const int8_t *m = &mat[p * P];
+			int32_t sum = 0;
+#pragma GCC unroll 32
+			for (int q = 0; q < P; q++)
+				sum += v[q] * m[q];
+			res[n * P + p] += sum;
+		}
+	}
+}
+
+// hwMMkernelAVX2Fixed: hwMMkernelAVX2() for a P that is a multiple of 8, so no lanes are padding
+template <int P>
+__attribute__((target("avx2")))
+static void hwMMkernelAVX2Fixed(int32_t *res, const int8_t *vecs, const int8_t *mat, int N, int) {
+	static_assert(P % 8 == 0, "P must fill whole registers");
+	const int PG = P / 2, R = P / 8;
+	alignas(32) int16_t matW[PG * P * 2];
+
+	// re-lay tile: matW[g][p][r] = mat[p][2g + r]
+	for (int p = 0; p < P; p++)
+#pragma GCC unroll 32
+		for (int q = 0; q < P; q++)
+			matW[((q >> 1) * P + p) * 2 + (q & 1)] = mat[p * P + q];
+
+	for (int n = 0; n < N; n++) {
+		const int8_t *v = &vecs[n * P];
+		__m256i acc[R];
+#pragma GCC unroll 4
+		for (int r = 0; r < R; r++)
+			acc[r] = _mm256_setzero_si256();
+#pragma GCC unroll 16
+		for (int g = 0; g < PG; g++) {
+			__m256i pair = _mm256_set1_epi32((int32_t) ((uint16_t) v[g * 2] | ((uint32_t) (uint16_t) v[g * 2 + 1] << 16)));
+#pragma GCC unroll 4
+			for (int r = 0; r < R; r++)
+				acc[r] = _mm256_add_epi32(acc[r], _mm256_madd_epi16(pair, _mm256_load_si256((const __m256i *) &matW[(g * P + r * 8) * 2])));
+		}
+#pragma GCC unroll 4
+		for (int r = 0; r < R; r++)
+			_mm256_storeu_si256((__m256i *) &res[n * P + r * 8], _mm256_add_epi32(acc[r], _mm256_loadu_si256((const __m256i *) &res[n * P + r * 8])));
+	}
+}
+
+// hwMMkernelAVX512VNNIFixed: hwMMkernelAVX512VNNI() for a P that is a multiple of 4; biasing the input bytes by 128 is an 
+// exclusive or with 0x80 of each, done 4 at a time. For P < 16 the upper lanes are padding and are masked off on store.
+template <int P>
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+static void hwMMkernelAVX512VNNIFixed(int32_t *res, const int8_t *vecs, const int8_t *mat, int N, int) {
+	static_assert(P % 4 == 0, "P must fill whole lane groups");
+	const int PV = (P + 15) & ~15, R = PV / 16;
+	const __mmask16 mask = P >= 16 ? 0xffff : (__mmask16) ((1 << P) - 1);
+	alignas(64) int8_t matV[P * PV];
+	alignas(64) int32_t bias[PV];
+
+	// re-lay tile: matV[g][p][r] = mat[p][4g + r], zero padded; bias[p] = -128 * sum of row p
+	if (PV != P) {
+		memset(matV, 0, sizeof(matV));
+		memset(bias, 0, sizeof(bias));
+	}
+	for (int p = 0; p < P; p++) {
+		int32_t sum = 0;
+#pragma GCC unroll 32
+		for (int q = 0; q < P; q++) {
+			matV[((q >> 2) * PV + p) * 4 + (q & 3)] = mat[p * P + q];
+			sum += mat[p * P + q];
+		}
+		bias[p] = -128 * sum;
+	}
+
+	for (int n = 0; n < N; n++) {
+		const int8_t *v = &vecs[n * P];
+		__m512i acc[R];
+#pragma GCC unroll 2
+		for (int r = 0; r < R; r++)
+			acc[r] = _mm512_load_si512((const void *) &bias[r * 16]);
+#pragma GCC unroll 8
+		for (int g = 0; g < P / 4; g++) {
+			uint32_t quad;
+			memcpy(&quad, &v[g * 4], sizeof(quad));
+			__m512i b = _mm512_set1_epi32((int32_t) (quad ^ 0x80808080u));
+#pragma GCC unroll 2
+			for (int r = 0; r < R; r++)
+				acc[r] = _mm512_dpbusd_epi32(acc[r], b, _mm512_load_si512((const void *) &matV[(g * PV + r * 16) * 4]));
+		}
+#pragma GCC unroll 2
+		for (int r = 0; r < R; r++) {
+			int32_t *dst = &res[n * P + r * 16];
+			_mm512_mask_storeu_epi32(dst, mask, _mm512_add_epi32(acc[r], _mm512_maskz_loadu_epi32(mask, dst)));
+		}
+	}
+}
+
+// the specialized kernel of a type for tile size P; NULL if there is none
+static hwMMkernel_t fixedKernel(hwMMkernelType_t type, int P) {
+	switch (P) {
+		case 8:
+			return type == HWMM_KERNEL_AVX512VNNI ? hwMMkernelAVX512VNNIFixed<8> : type == HWMM_KERNEL_AVX2 ? hwMMkernelAVX2Fixed<8> : hwMMkernelScalarFixed<8>;
+		case 16:
+			return type == HWMM_KERNEL_AVX512VNNI ? hwMMkernelAVX512VNNIFixed<16> : type == HWMM_KERNEL_AVX2 ? hwMMkernelAVX2Fixed<16> : hwMMkernelScalarFixed<16>;
+		case 32:
+			return type == HWMM_KERNEL_AVX512VNNI ? hwMMkernelAVX512VNNIFixed<32> : type == HWMM_KERNEL_AVX2 ? hwMMkernelAVX2Fixed<32> : hwMMkernelScalarFixed<32>;
+		default:
+			return NULL;
+	}
+}
+
+// check CPU support for a kernel type
+static bool kernelSupported(int type) {
+	switch (type) {
+		case HWMM_KERNEL_SCALAR:
+			return true;
+		case HWMM_KERNEL_AVX2:
+			return __builtin_cpu_supports("avx2");
+		case HWMM_KERNEL_AVX512VNNI:
+			return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni");
+		default:
+			return false;
+	}
+}
+
+// resolve a requested kernel type to one this CPU can run
+hwMMkernelType_t hwMMresolveKernel(int type) {
+	if (type != HWMM_KERNEL_AUTO && kernelSupported(type))
+		return (hwMMkernelType_t) type;
+	if (kernelSupported(HWMM_KERNEL_AVX512VNNI))
+		return HWMM_KERNEL_AVX512VNNI;
+	if (kernelSupported(HWMM_KERNEL_AVX2))
+		return HWMM_KERNEL_AVX2;
+	return HWMM_KERNEL_SCALAR;
+}
+
+// true if there are kernels specialized for tile size P
+bool hwMMspecialized(int P) {
+	for (size_t i = 0; i < sizeof(hwMMfixedSizes) / sizeof(hwMMfixedSizes[0]); i++)
+		if (hwMMfixedSizes[i] == P)
+			return true;
+	return false;
+}
+
+// select kernel function; the specialized one for P if there is one
+hwMMkernel_t hwMMselectKernel(int type, int P) {
+	hwMMkernelType_t resolved = hwMMresolveKernel(type);
+	hwMMkernel_t fixed = hwMMspecialized(P) ? fixedKernel(resolved, P) : NULL;
+	if (fixed)
+		return fixed;
+	switch (resolved) {
+		case HWMM_KERNEL_AVX512VNNI:
+			return hwMMkernelAVX512VNNI;
+		case HWMM_KERNEL_AVX2:
+			return hwMMkernelAVX2;
+		default:
+			return hwMMkernelScalar;
+	}
+}
+
+// kernel name for diagnostics
+const char *hwMMkernelName(int type) {
+	switch (hwMMresolveKernel(type)) {
+		case HWMM_KERNEL_AVX512VNNI:
+			return "avx512vnni";
+		case HWMM_KERNEL_AVX2:
+			return "avx2";
+		default:
+			return "scalar";
+	}
+}
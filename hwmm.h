@@ -0,0 +1,37 @@
+/**
+ * @file hwmm.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief simulated HW multiplier kernels.
+ */
+#ifndef _HWMM_H_
+#define _HWMM_H_
+#include <stdint.h>
+
+// A multiplier kernel performs one step of the N x P x P HW multiplier:
+//
+//		res[n * P + p] += dot(vecs[n * P .. n * P + P - 1], mat[p * P .. p * P + P - 1])		for n < N, p < P
+//
+// "vecs" are the N P-wide input vectors, "mat" is a P x P operand tile whose row p holds the slice of filter p, and "res"
+// holds the N x P accumulators. Kernels add exact int32 dot products; the width and overflow behaviour of the modeled HW 
+// accumulators is applied on top of that (see hwMMepilogue_t): the low 8 or 16 bits of an exact sum are what wrapping 
+// accumulators of that width would hold, whatever the order of the additions.
+typedef void (*hwMMkernel_t)(int32_t *res, const int8_t *vecs, const int8_t *mat, int N, int P);
+
+// kernel types (option_kernel)
+enum hwMMkernelType_t {
+	HWMM_KERNEL_AUTO = 0,		// best kernel the CPU supports
+	HWMM_KERNEL_SCALAR,			// portable scalar loops
+	HWMM_KERNEL_AVX2,			// AVX2, 16-bit products paired into 32-bit lanes
+	HWMM_KERNEL_AVX512VNNI		// AVX-512 VNNI, 4-way 8-bit dot products into 32-bit lanes
+};
+
+// pick a kernel; an unsupported or unknown type falls back to the best supported one. For a tile size P with specialized
+// kernels (8, 16 and 32; see hwMMspecialized()), hwMMselectKernel() returns the one compiled for that P, which must then 
+// be the P it is called with; P = 0 (or any other size) selects the generic kernel for any P.
+extern hwMMkernelType_t hwMMresolveKernel(int type);
+extern hwMMkernel_t hwMMselectKernel(int type, int P = 0);
+extern bool hwMMspecialized(int P);
+extern const char *hwMMkernelName(int type);
+
+#endif // _HWMM_H_
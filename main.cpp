@@ -7,20 +7,29 @@
 #include <stdio.h>
 #include <iostream>
 #include <getopt.h>
+#include <thread>
 #include "main.h"
+#include "conv.h"
+#include "hwmm.h"
+#include "epilogue.h"
+#include "tune.h"
 
 using namespace std;
 
 // HW Multiplier configuration
 struct hwMM_t hwMM = {		// set defaults
 	16,
-	16
+	16,
+	0,
+	64
 };
 
 // command line processing options
 int option_maxInt = 16;
 int option_hw_N = 16;
 int option_hw_P = 16;
+int option_engines = 0;
+int option_loadBytes = 64;
 int option_minW = 16;
 int option_minH = 16;
 int option_minD = 1;
@@ -34,6 +43,40 @@ int option_maxKW = 11;
 int option_maxKH = 11;
 int option_maxC = 32;
 int option_verbose = 0;
+int option_implicit = 1;
+int option_layout = TENSOR_LAYOUT_CHW;
+int option_kernel = HWMM_KERNEL_AUTO;
+int option_specialize = 1;
+int option_threads = 0;
+int option_batch = 1;
+int option_stride = 1;
+int option_dilation = 1;
+int option_padding = 0;
+int option_groups = 1;
+int option_groupPack = 1;
+int option_sparsity = 0;
+int option_sparse = 1;
+int option_arena = 1;
+int option_counters = 0;
+int option_bench = 0;
+int option_warmup = 1;
+int option_trials = 1;
+int option_seed = 0;
+int option_reference = CONV_REF_INT;
+int option_accum = HWMM_ACC_WRAP8;
+int option_bias = 0;
+int option_activation = HWMM_ACT_NONE;
+int option_clampMin = -128;
+int option_clampMax = 127;
+int option_band = 2;
+int option_dataflow = CONV_FLOW_AUTO;
+int option_pipeline = 0;
+int option_tune = 0;
+int option_tuneMetric = CONV_TUNE_TIME;
+const char *option_activationFile = NULL;
+const char *option_filterFile = NULL;
+const char *option_save = NULL;
+const char *option_tuneCache = "litest.tune";
 
 static struct option options[] = {
 	// generic help; must ALWAYS be first index
@@ -46,6 +89,50 @@ static struct option options[] = {
 	// options for HW multiplier
 	{ "hwN", required_argument, &option_hw_N, 0 },
 	{ "hwP", required_argument, &option_hw_P, 0 },
+	{ "engines", required_argument, &option_engines, 0 },
+	{ "loadBytes", required_argument, &option_loadBytes, 0 },
+	{ "accum", required_argument, &option_accum, 0 },
+	{ "bias", required_argument, &option_bias, 0 },
+	{ "activation", required_argument, &option_activation, 0 },
+	{ "clampMin", required_argument, &option_clampMin, 0 },
+	{ "clampMax", required_argument, &option_clampMax, 0 },
+
+	// options for the simulator
+	{ "implicit", required_argument, &option_implicit, 0 },
+	{ "layout", required_argument, &option_layout, 0 },
+	{ "kernel", required_argument, &option_kernel, 0 },
+	{ "specialize", required_argument, &option_specialize, 0 },
+	{ "threads", required_argument, &option_threads, 0 },
+	{ "batch", required_argument, &option_batch, 0 },
+	{ "arena", required_argument, &option_arena, 0 },
+	{ "counters", required_argument, &option_counters, 0 },
+	{ "sparse", required_argument, &option_sparse, 0 },
+	{ "dataflow", required_argument, &option_dataflow, 0 },
+	{ "pipeline", required_argument, &option_pipeline, 0 },
+	{ "tune", required_argument, &option_tune, 0 },
+	{ "tuneMetric", required_argument, &option_tuneMetric, 0 },
+	{ "tuneCache", required_argument, NULL, 'u' },
+
+	// options for trials
+	{ "trials", required_argument, &option_trials, 0 },
+	{ "seed", required_argument, &option_seed, 0 },
+	{ "reference", required_argument, &option_reference, 0 },
+	{ "activations", required_argument, NULL, 'a' },
+	{ "filters", required_argument, NULL, 'f' },
+	{ "save", required_argument, NULL, 's' },
+
+	// options for the benchmark suite
+	{ "bench", required_argument, &option_bench, 0 },
+	{ "warmup", required_argument, &option_warmup, 0 },
+	{ "network", required_argument, NULL, 'n' },
+	{ "band", required_argument, &option_band, 0 },
+
+	// options for the convolution
+	{ "stride", required_argument, &option_stride, 0 },
+	{ "dilation", required_argument, &option_dilation, 0 },
+	{ "padding", required_argument, &option_padding, 0 },
+	{ "groups", required_argument, &option_groups, 0 },
+	{ "groupPack", required_argument, &option_groupPack, 0 },
 
 	// options for activations; defines ranges on tensor sizes
 	{ "minW", required_argument, &option_minW, 0 },
@@ -56,6 +143,7 @@ static struct option options[] = {
 	{ "maxD", required_argument, &option_maxD, 0 },
 
 	// options for filters; defines ranges on filter sizes
+	{ "sparsity", required_argument, &option_sparsity, 0 },
 	{ "minKW", required_argument, &option_minKW, 0 },
 	{ "minKH", required_argument, &option_minKH, 0 },
 	{ "minC", required_argument, &option_minC, 0 },
@@ -71,6 +159,42 @@ void usage(int argc, char **argv) {
 	cerr << "usage: " << argv[0] << " <options>\n    where options are:" << std::endl;
 	cerr << "        --hwN <n>\t:\tHW multipler vector width (default " << option_hw_N << ")" << std::endl;
 	cerr << "        --hwP <n>\t:\tHW multipler MM dimensions (default " << option_hw_P << ")" << std::endl;
+	cerr << "        --engines <n>\t:\tHW multiplier engines sharing one load port, modeled in cycles; 0 = one engine, not modeled (default " << option_engines << ")" << std::endl;
+	cerr << "        --loadBytes <n>\t:\tbytes per cycle of the load port shared by the engines (default " << option_loadBytes << ")" << std::endl;
+	cerr << "        --accum <n>\t:\taccumulators; 0 = 8-bit wrap, 1 = 8-bit saturate, 2/3 = 16/32-bit with requantize (default " << option_accum << ")" << std::endl;
+	cerr << "        --bias <n>\t:\tadd random per channel biases on writeback; 0 = off (default " << option_bias << ")" << std::endl;
+	cerr << "        --activation <n>\t:\tactivation on writeback; 0 = none, 1 = relu, 2 = relu6 (Q3.4), 3 = clamp (default " << option_activation << ")" << std::endl;
+	cerr << "        --clampMin <n>\t:\tlower bound for --activation 3 (default " << option_clampMin << ")" << std::endl;
+	cerr << "        --clampMax <n>\t:\tupper bound for --activation 3 (default " << option_clampMax << ")" << std::endl;
+	cerr << "        --implicit <n>\t:\tgather multiplier vectors implicitly; 0 = extract subtensors (default " << option_implicit << ")" << std::endl;
+	cerr << "        --layout <n>\t:\ttensor layout; 0 = channel first (CHW), 1 = channel last (HWC), window rows gathered with one copy (default " << option_layout << ")" << std::endl;
+	cerr << "        --kernel <n>\t:\tmultiplier kernel; 0 = auto, 1 = scalar, 2 = avx2, 3 = avx512vnni (default " << option_kernel << ")" << std::endl;
+	cerr << "        --specialize <n>\t:\tuse the kernels specialized for P = 8, 16 and 32; 0 = generic kernels (default " << option_specialize << ")" << std::endl;
+	cerr << "        --threads <n>\t:\thost threads for simulation; 0 = all cores (default " << option_threads << ")" << std::endl;
+	cerr << "        --batch <n>\t:\tbatch size; > 1 runs a weight stationary batched trial (default " << option_batch << ")" << std::endl;
+	cerr << "        --arena <n>\t:\tallocate tensors from per trial/tile arenas; 0 = heap (default " << option_arena << ")" << std::endl;
+	cerr << "        --counters <n>\t:\treport HW multiplier utilization and data movement; 0 = off (default " << option_counters << ")" << std::endl;
+	cerr << "        --sparse <n>\t:\tskip all-zero filter tiles; 0 = multiply every tile (default " << option_sparse << ")" << std::endl;
+	cerr << "        --dataflow <n>\t:\tdataflow; 0 = tuned (default os-channel), 1 = os-channel, 2 = os-surface, 3 = weight stationary, 4 = input stationary (default " << option_dataflow << ")" << std::endl;
+	cerr << "        --pipeline <n>\t:\tgather the next unit's vectors on a producer thread while the current one multiplies, and model double buffered engines; 0 = off (default " << option_pipeline << ")" << std::endl;
+	cerr << "        --tune <n>\t:\tautotune the dataflow of shapes missing from the tuning cache; 0 = off (default " << option_tune << ")" << std::endl;
+	cerr << "        --tuneMetric <n>\t:\tautotune for 0 = host time, 1 = modeled bytes loaded (default " << option_tuneMetric << ")" << std::endl;
+	cerr << "        --tuneCache <file>\t:\ttuning cache file (default " << option_tuneCache << ")" << std::endl;
+	cerr << "        --trials <n>\t:\tnumber of independent trials, run in parallel on the host threads (default " << option_trials << ")" << std::endl;
+	cerr << "        --seed <n>\t:\tbase random seed; trial t uses seed n + t; 0 = random (default " << option_seed << ")" << std::endl;
+	cerr << "        --reference <n>\t:\tresult check: 0 = float, 1 = exact int32 and bit for bit, 2 = both (default " << option_reference << ")" << std::endl;
+	cerr << "        --activations <file>\t:\tread the activations from a tensor file; > 1 tensors make a batch (default random)" << std::endl;
+	cerr << "        --filters <file>\t:\tread the filter set from a tensor file (default random)" << std::endl;
+	cerr << "        --save <prefix>\t:\twrite the activations, filters and result of a single trial to <prefix>_*.tensor (default off)" << std::endl;
+	cerr << "        --bench <n>\t:\trun the benchmark suite with n timed repeats per case; 0 = off (default " << option_bench << ")" << std::endl;
+	cerr << "        --warmup <n>\t:\tuntimed warmup runs per benchmark case (default " << option_warmup << ")" << std::endl;
+	cerr << "        --network <file>\t:\trun the conv network described in file, unfused and fused (default off)" << std::endl;
+	cerr << "        --band <n>\t:\toutput rows per band in fused network execution (default " << option_band << ")" << std::endl;
+	cerr << "        --stride <n>\t:\tconvolution stride (default " << option_stride << ")" << std::endl;
+	cerr << "        --dilation <n>\t:\tconvolution dilation (default " << option_dilation << ")" << std::endl;
+	cerr << "        --padding <n>\t:\tconvolution padding; 0 = VALID, 1 = SAME (default " << option_padding << ")" << std::endl;
+	cerr << "        --groups <n>\t:\tconvolution groups; 1 = dense, 0 = depthwise (default " << option_groups << ")" << std::endl;
+	cerr << "        --groupPack <n>\t:\tpack several groups into one multiplier tile; 0 = one group per tile (default " << option_groupPack << ")" << std::endl;
 	cerr << "        --minW <n>\t:\tminimum activation tensor width (default " << option_minW << ")" << std::endl;
 	cerr << "        --maxW <n>\t:\tmaximum activation tensor width (default " << option_maxW << ")" << std::endl;
 	cerr << "        --minH <n>\t:\tminimum activation tensor height (default " << option_minH << ")" << std::endl;
@@ -83,21 +207,26 @@ void usage(int argc, char **argv) {
 	cerr << "        --maxKW <n>\t:\tmaximum filter tensor width (default " << option_maxKH << ")" << std::endl;
 	cerr << "        --minKH <n>\t:\tminimum filter tensor height (default " << option_minKH << ")" << std::endl;
 	cerr << "        --maxKH <n>\t:\tmaximum filter tensor height (default " << option_maxKH << ")" << std::endl;
+	cerr << "        --sparsity <n>\t:\tprune random P x P blocks of the filter weights to n percent zeros (default " << option_sparsity << ")" << std::endl;
 	cerr << "        --maxInt <n>\t:\tintegers will be in the range [-n .. n] (default n = " << option_maxInt << ")" << std::endl; 
 	cerr << "        -v, --verbose\t:\tbe verbose" << std::endl;
 	cerr << "        -h, --help\t:\tprints help" << std::endl;
-	cerr << "        -o <file>\t:\tsave matrices to csv file" << std::endl;
+	cerr << "        -o <file>\t:\tsave matrices to csv file (benchmark results with --bench; json if the name ends in .json)" << std::endl;
 	exit(0);
 }
 
 // forward declarations
-extern void conv2dTrial(const char *);
+extern void conv2dTrials(const char *);
+extern void benchSuite(int, const char *);
+extern void networkTrial(const char *, const char *);
+extern bool checkTrialFiles();
 
 // main program
 int main (int argc, char **argv) {
 	int c;
 	int option_index;
 	char *opt_o = NULL;
+	char *opt_network = NULL;
 
 	while ((c = getopt_long(argc, argv, "vhco:", options, &option_index)) != -1) {
 		switch (c) {
@@ -112,6 +241,21 @@ int main (int argc, char **argv) {
 			case 'o':
 				opt_o = optarg;
 				break;
+			case 'n':
+				opt_network = optarg;
+				break;
+			case 'a':
+				option_activationFile = optarg;
+				break;
+			case 'f':
+				option_filterFile = optarg;
+				break;
+			case 's':
+				option_save = optarg;
+				break;
+			case 'u':
+				option_tuneCache = optarg;
+				break;
 			case 'h':
 				usage(argc, argv);
 				break;
@@ -127,20 +271,86 @@ int main (int argc, char **argv) {
 		option_hw_N = 2;
 	if (option_hw_P < 3)
 		option_hw_P = 3;
+	if (option_engines < 0)
+		option_engines = 0;
+	if (option_engines > 64)
+		option_engines = 64;
+	if (option_loadBytes < 1)
+		option_loadBytes = 1;
+	if (option_layout != TENSOR_LAYOUT_HWC)
+		option_layout = TENSOR_LAYOUT_CHW;
+	if (option_batch < 1)
+		option_batch = 1;
+	if (option_accum < HWMM_ACC_WRAP8 || option_accum > HWMM_ACC_WIDE32)
+		option_accum = HWMM_ACC_WRAP8;
+	if (option_activation < HWMM_ACT_NONE || option_activation > HWMM_ACT_CLAMP)
+		option_activation = HWMM_ACT_NONE;
+	if (option_clampMin > option_clampMax)
+		option_clampMax = option_clampMin;
+	if (option_reference < CONV_REF_FLOAT || option_reference > CONV_REF_BOTH)
+		option_reference = CONV_REF_INT;
+	if (option_dataflow < CONV_FLOW_AUTO || option_dataflow > convDataflows)
+		option_dataflow = CONV_FLOW_AUTO;
+	if (option_tuneMetric != CONV_TUNE_BYTES)
+		option_tuneMetric = CONV_TUNE_TIME;
+	if (option_trials < 1)
+		option_trials = 1;
+	if (option_warmup < 0)
+		option_warmup = 0;
+	if (option_band < 1)
+		option_band = 1;
+	if (option_stride < 1)
+		option_stride = 1;
+	if (option_dilation < 1)
+		option_dilation = 1;
+	if (option_padding != CONV_PAD_SAME)
+		option_padding = CONV_PAD_VALID;
+	if (option_sparsity < 0)
+		option_sparsity = 0;
+	if (option_sparsity > 100)
+		option_sparsity = 100;
+	if (option_groups < 0)
+		option_groups = 1;
+	if (option_threads <= 0)
+		option_threads = std::thread::hardware_concurrency();
+	if (option_threads <= 0)
+		option_threads = 1;
+
+	// fit the options to tensor files given for the trials
+	if (!checkTrialFiles())
+		return 1;
 
 	// set up HW config
 	hwMM.N = option_hw_N;
 	hwMM.P = option_hw_P;
+	hwMM.engines = option_engines;
+	hwMM.loadBytes = option_loadBytes;
 
 	// if option print requested
 	if (option_verbose) {
-		cout << "HW MM: " << hwMM.N << " vectors by " << hwMM.P << " x " << hwMM.P << " MM" << std::endl;
+		hwMMepilogue_t epi(option_accum);
+		epi.setActivation(option_activation, option_clampMin, option_clampMax);
+		cout << "HW MM: ";
+		if (hwMM.engines)
+			cout << hwMM.engines << " engines of ";
+		cout << hwMM.N << " vectors by " << hwMM.P << " x " << hwMM.P << " MM, ";
+		if (hwMM.engines)
+			cout << hwMM.loadBytes << " bytes/cycle load port, ";
+		cout << epi.name() << " accumulators, " << (option_bias ? "bias, " : "") << 
+				epi.activationName() << " activation, " << hwMMkernelName(option_kernel) << 
+				(option_specialize && hwMMspecialized(hwMM.P) ? " specialized" : "") << " kernel, " << convDataflowName(option_dataflow) << " dataflow, " << (option_pipeline ? "pipelined, " : "") << (option_layout == TENSOR_LAYOUT_HWC ? "HWC layout, " : "") << 
+				option_threads << " threads" << std::endl;
 		cout << "Ranges: [" << option_minW << ".." << option_maxW << "]x[" << option_minH << ".." << option_maxH << "]x[" << option_minD << ".." << option_maxD << "] by [" << 
 				option_minC << ".." << option_maxC << "] of [" << option_minKW << ".." << option_maxKW << "]x[" << option_minKH << ".." << option_maxKH << "]x[" << option_minD << ".." << option_maxD << 
 				"], maxInt = " << option_maxInt << std::endl;
 	}
 
-	// do a trial and quit
-	conv2dTrial(opt_o);
+	// run the benchmark suite, a network, or do the trials, and quit
+	if (option_bench > 0)
+		benchSuite(option_bench, opt_o);
+	else if (opt_network)
+		networkTrial(opt_network, opt_o);
+	else
+		conv2dTrials(opt_o);
 	return 0;
 }
@@ -11,6 +11,8 @@
 struct hwMM_t {
 	int N;				// dimension of the vector array input to the MM (N)
 	int P;				// dimension of the operand matrix (PxP)
+	int engines;		// multiplier engines sharing one load port; 0 = one engine, not modeled
+	int loadBytes;		// bytes per cycle of the shared load port
 }; 
 
 extern hwMM_t hwMM;
@@ -19,6 +21,8 @@ extern hwMM_t hwMM;
 extern int option_maxInt;
 extern int option_hw_N;
 extern int option_hw_P;
+extern int option_engines;
+extern int option_loadBytes;
 extern int option_minW;
 extern int option_minH;
 extern int option_minD;
@@ -32,5 +36,39 @@ extern int option_maxKW;
 extern int option_maxKH;
 extern int option_maxC;
 extern int option_verbose;
+extern int option_implicit;
+extern int option_layout;
+extern int option_kernel;
+extern int option_specialize;
+extern int option_threads;
+extern int option_batch;
+extern int option_stride;
+extern int option_dilation;
+extern int option_padding;
+extern int option_groups;
+extern int option_groupPack;
+extern int option_sparsity;
+extern int option_sparse;
+extern int option_arena;
+extern int option_counters;
+extern int option_bench;
+extern int option_warmup;
+extern int option_trials;
+extern int option_seed;
+extern int option_reference;
+extern int option_accum;
+extern int option_bias;
+extern int option_activation;
+extern int option_clampMin;
+extern int option_clampMax;
+extern int option_band;
+extern int option_dataflow;
+extern int option_pipeline;
+extern int option_tune;
+extern int option_tuneMetric;
+extern const char *option_activationFile;
+extern const char *option_filterFile;
+extern const char *option_save;
+extern const char *option_tuneCache;
 
 #endif // _MAIN_H_
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <sstream>
 #include <string>
+#include "arena.h"
 #include "vector.h"
 
 // Matrix_t class
@@ -17,7 +18,7 @@ class Matrix_t {
 public:
 	// Constructor 
 	Matrix_t(int _W = 1, int _H = 1) : W(_W), H(_H), len(_W * _H) {
-		data = new T[len];
+		data = arenaAllocate<T>(arena = Arena_t::current(), len);
 		T *dst = data;
 
 		for (int i = 0; i < W; i++)
@@ -27,7 +28,7 @@ public:
 
 	// Copy constructor
 	Matrix_t(const Matrix_t<T>& m) : W(m.W), H(m.H), len(m.W * m.H) { 
-		data = new T[len];
+		data = arenaAllocate<T>(arena = Arena_t::current(), len);
 		T *src = m.data;
 		T *dst = data;
 
@@ -36,8 +37,41 @@ public:
 				*dst++ = *src++;
 	}
 
+	// Move constructor; takes over the storage of "m"
+	Matrix_t(Matrix_t<T>&& m) : data(m.data), arena(m.arena), len(m.len), W(m.W), H(m.H) {
+		m.data = NULL;
+		m.arena = NULL;
+		m.len = m.W = m.H = 0;
+	}
+
 	// Destructor
-	virtual ~Matrix_t() { delete data; }
+	virtual ~Matrix_t() { arenaFree(arena, data); }
+
+	// Assignment: copy (deep) and move
+	Matrix_t<T>& operator= (const Matrix_t<T>& m) {
+		if (this != &m) {
+			Matrix_t<T> copy(m);
+			swap(copy);
+		}
+		return *this;
+	}
+	Matrix_t<T>& operator= (Matrix_t<T>&& m) {
+		if (this != &m)
+			swap(m);
+		return *this;
+	}
+
+	// exchange contents with another matrix
+	void swap(Matrix_t<T>& m) {
+		std::swap(data, m.data);
+		std::swap(arena, m.arena);
+		std::swap(len, m.len);
+		std::swap(W, m.W);
+		std::swap(H, m.H);
+	}
+
+	// non-owning view of row j
+	VectorView_t<T> view(int j) const { assert(j >= 0 && j < H); return VectorView_t<T>(&data[j * W], W); }
 
 	// dimension methods
 	inline const int width() const { return W; }
@@ -47,11 +81,14 @@ public:
 	// return a reference to a tensor member
 	inline T& operator()(int i, int j) {  assert(i >= 0 && i < W && j >= 0 && j < H); return data[j * W + i]; }
 
+	// return a pointer to row j (W contiguous elements)
+	inline T* pointer(int j = 0) { assert(j >= 0 && j < H); return &data[j * W]; }
+
 	// Matrix multiply on vector, "result = m * v"
 	Vector_t<T> mm(const Vector_t<T>& v) const {
 		Vector_t<T> result(H);
 
-		assert(W = v.W);
+		assert(W == v.W);
 		for (int j = 0; j < H; j++) {
 			T sum = 0;
 			T *src1 = &data[j * W];
@@ -66,7 +103,7 @@ public:
 
 	// Generate a string with matrix geoemtry
 	std::string operator() () const {
-	   	static std::ostringstream buffer;
+	   	std::ostringstream buffer;
 	    buffer << "[" << W << "," << H << "]";
 	    return buffer.str();
 	}
@@ -80,8 +117,9 @@ public:
 
 private:
 	T *data;
-	const int len;
-	const int W, H;
+	Arena_t *arena;		// where "data" came from (NULL = heap)
+	int len;
+	int W, H;
 	
 	template <typename TT> friend class Tensor_t;
 };
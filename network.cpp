@@ -0,0 +1,464 @@
+/**
+ * @file network.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief multi-layer conv networks: a text description, and unfused or fused (row band) execution on the simulated HW multiplier.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "main.h"
+#include "network.h"
+#include "timer.h"
+
+// forward declarations
+extern Tensor_t<int8_t> *simulatedConv2D(Tensor_t<int8_t> *, TensorArray_t<int8_t> *, const conv2DParams_t &, const PackedFilters_t<int8_t> *, hwMMcounters_t *, const hwMMepilogue_t *, const convBand_t *);
+extern void pruneFilters(TensorArray_t<int8_t> &, int, std::mt19937 &);
+extern Tensor_t<int32_t> *referenceConv2DExact(const Tensor_t<int8_t> *, TensorArray_t<int8_t> *, const conv2DParams_t &, int, int);
+
+// Hidden layer inputs are the outputs of a calibrated layer: about normal with 4 standard deviations at 127. Uniform data
+// in [-55, 55] has the same variance, so later layers are calibrated as if their inputs were that.
+static const int hiddenMaxInt = 55;
+
+// Destructor
+convNetwork_t::~convNetwork_t() {
+	for (size_t l = 0; l < layer.size(); l++) {
+		delete layer[l].packed;
+		delete layer[l].filtSet;
+	}
+}
+
+// read a description
+bool convNetwork_t::parse(std::istream& is, std::string& error) {
+	std::string line;
+	int lineNo = 0;
+
+	while (std::getline(is, line)) {
+		std::ostringstream where;
+		std::string word;
+		lineNo++;
+		where << "line " << lineNo << ": ";
+		size_t hash = line.find('#');
+		if (hash != std::string::npos)
+			line.erase(hash);
+		std::istringstream words(line);
+		if (!(words >> word))
+			continue;
+
+		if (word == "input") {
+			if (W || !layer.empty()) {
+				error = where.str() + "input given twice or after a layer";
+				return false;
+			}
+			if (!(words >> W >> H >> D) || W < 1 || H < 1 || D < 1) {
+				error = where.str() + "expected input <W> <H> <D>";
+				return false;
+			}
+		} else if (word == "conv") {
+			convLayer_t L;
+			char x;
+			if (!W) {
+				error = where.str() + "conv before input";
+				return false;
+			}
+			if (!(words >> L.C >> L.KW >> x >> L.KH) || x != 'x' || L.C < 1 || L.KW < 1 || L.KH < 1) {
+				error = where.str() + "expected conv <C> <KW>x<KH>";
+				return false;
+			}
+			bool depthwise = false;
+			while (words >> word) {
+				int n = 0;
+				if (word == "stride" || word == "dilation" || word == "groups") {
+					if (!(words >> n) || n < 1) {
+						error = where.str() + "expected " + word + " <n>";
+						return false;
+					}
+					if (word == "stride")
+						L.params.strideW = L.params.strideH = n;
+					else if (word == "dilation")
+						L.params.dilationW = L.params.dilationH = n;
+					else
+						L.params.groups = n;
+				} else if (word == "depthwise")
+					depthwise = true;
+				else if (word == "valid")
+					L.params.padding = CONV_PAD_VALID;
+				else if (word == "same")
+					L.params.padding = CONV_PAD_SAME;
+				else if (word == "none")
+					L.activation = HWMM_ACT_NONE;
+				else if (word == "relu")
+					L.activation = HWMM_ACT_RELU;
+				else if (word == "relu6")
+					L.activation = HWMM_ACT_RELU6;
+				else if (word == "clamp")
+					L.activation = HWMM_ACT_CLAMP;
+				else {
+					error = where.str() + "unknown conv attribute \"" + word + "\"";
+					return false;
+				}
+			}
+
+			// the input is the previous output
+			if (layer.empty()) {
+				L.W = W; L.H = H; L.D = D;
+			} else {
+				L.W = layer.back().OW; L.H = layer.back().OH; L.D = layer.back().C;
+			}
+			if (depthwise)
+				L.params.groups = L.D;
+			if (L.D % L.params.groups || L.C % L.params.groups) {
+				error = where.str() + "input depth and filter count must be multiples of the groups";
+				return false;
+			}
+			conv2DGeometry_t geom(L.W, L.H, L.KW, L.KH, L.params);
+			L.OW = geom.OW;
+			L.OH = geom.OH;
+			if (L.OW < 1 || L.OH < 1) {
+				error = where.str() + "filter larger than its input";
+				return false;
+			}
+			layer.push_back(L);
+		} else {
+			error = where.str() + "unknown statement \"" + word + "\"";
+			return false;
+		}
+	}
+	if (layer.empty()) {
+		error = "no conv layers";
+		return false;
+	}
+	return true;
+}
+
+// Generate filters with data in [-option_maxInt, option_maxInt] (pruned per option_sparsity), pack them for the current multiplier, and calibrate each
+// epilogue for option_accum: the first layer for inputs in [-option_maxInt, option_maxInt], the others per hiddenMaxInt.
+// With option_bias, channels get random biases as in genEpilogue(). The filters are stored in option_layout, which the input
+// of run(), runFused() and reference() must have too.
+void convNetwork_t::setup(std::mt19937& gen) {
+	std::uniform_int_distribution<> randData(-option_maxInt, option_maxInt);
+
+	for (size_t l = 0; l < layer.size(); l++) {
+		convLayer_t& L = layer[l];
+		delete L.packed;
+		delete L.filtSet;
+		L.filtSet = new TensorArray_t<int8_t>(L.C, L.KW, L.KH, L.KD(), (tensorLayout_t) option_layout);
+		int8_t *w = L.filtSet->buffer();
+		for (int i = 0; i < L.C * L.filtSet->stride(); i++)
+			w[i] = randData(gen);
+		if (option_sparsity > 0)
+			pruneFilters(*L.filtSet, option_sparsity, gen);
+		L.packed = new PackedFilters_t<int8_t>(*L.filtSet, hwMM.P, L.params.groups, option_groupPack, option_sparse);
+
+		L.epilogue = hwMMepilogue_t::calibrate(option_accum, *L.filtSet, l ? hiddenMaxInt : option_maxInt);
+		if (option_bias)
+			for (int c = 0; c < L.C; c++) {
+				int sigma = (int) lround(127.0 / (4.0 * L.epilogue.scaleD[c] * L.epilogue.unitD[c]));
+				std::uniform_int_distribution<> randBias(-sigma, sigma);
+				L.epilogue.setBias(c, randBias(gen));
+			}
+		L.epilogue.setActivation(L.activation, option_clampMin, option_clampMax);
+	}
+}
+
+// layer by layer: the input and output of each layer exist in full
+Tensor_t<int8_t> *convNetwork_t::run(Tensor_t<int8_t> *input, size_t *peak, hwMMcounters_t *counters) const {
+	Tensor_t<int8_t> *act = input;
+	size_t live = 0, maxLive = 0;
+	hwMMcounters_t count;
+
+	if (counters)
+		counters->clear();
+	for (size_t l = 0; l < layer.size(); l++) {
+		const convLayer_t& L = layer[l];
+		bool last = l + 1 == layer.size();
+		Tensor_t<int8_t> *out = simulatedConv2D(act, L.filtSet, L.params, L.packed, &count, &L.epilogue, NULL);
+		if (counters)
+			*counters += count;
+		if (!last)
+			live += L.outputBytes();
+		maxLive = std::max(maxLive, live);
+		if (act != input) {
+			delete act;
+			live -= layer[l - 1].outputBytes();
+		}
+		act = out;
+	}
+	if (peak)
+		*peak = maxLive;
+	return act;
+}
+
+// bandBuffer_t: the live rows [lo, hi) of an intermediate tensor in a fused run. The rows are kept packed as a
+// W x (hi - lo) x D tensor in storage for "capacity" rows, which is allocated once. Channel first, the channel planes
+// are back to back and each moves on its own; channel last, the live rows are one contiguous block.
+struct bandBuffer_t {
+	int W, D;
+	int lo, hi;
+	int capacity;
+	tensorLayout_t layout;
+	std::vector<int8_t> storage;
+
+	bandBuffer_t(int _W, int _D, int _capacity, tensorLayout_t _layout) : W(_W), D(_D), lo(0), hi(0), capacity(_capacity), layout(_layout), 
+			storage((size_t) _W * _capacity * _D) {}
+
+	// the live rows, as a tensor on the buffer's storage
+	Tensor_t<int8_t> *tensor() { return new Tensor_t<int8_t>(storage.data(), W, hi - lo, D, layout); }
+
+	// drop the rows below "row"
+	void trim(int row) {
+		int drop = row - lo, h = hi - row;
+		if (drop <= 0)
+			return;
+		if (layout == TENSOR_LAYOUT_HWC)
+			memmove(storage.data(), storage.data() + (size_t) drop * W * D, (size_t) h * W * D);
+		else
+			for (int k = 0; k < D; k++)						// planes only move down
+				memmove(storage.data() + (size_t) k * W * h, storage.data() + ((size_t) k * (h + drop) + drop) * W, (size_t) W * h);
+		lo = row;
+	}
+
+	// append the rows of "band" (W x b x D) after row hi - 1
+	void append(const Tensor_t<int8_t>& band) {
+		int h = hi - lo, b = band.height();
+		assert(band.width() == W && band.depth() == D && band.layout() == layout && h + b <= capacity);
+		if (layout == TENSOR_LAYOUT_HWC)
+			memcpy(storage.data() + (size_t) h * W * D, &band(0, 0, 0), (size_t) b * W * D);
+		else
+			for (int k = D - 1; k >= 0; k--) {				// planes only move up
+				memmove(storage.data() + (size_t) k * W * (h + b), storage.data() + (size_t) k * W * h, (size_t) W * h);
+				memcpy(storage.data() + ((size_t) k * (h + b) + h) * W, &band(0, 0, k), (size_t) W * b);
+			}
+		hi += b;
+	}
+};
+
+// fused run state
+struct fusedRun_t {
+	const std::vector<convLayer_t>& layer;
+	Tensor_t<int8_t> *input;					// level 0; level l > 0 is the output of layer l - 1
+	Tensor_t<int8_t> *output;					// output of the last layer
+	std::vector<bandBuffer_t *> buffer;			// levels 1 .. L - 1
+	int band;
+	size_t live, maxLive;
+	hwMMcounters_t counters, count;
+
+	fusedRun_t(const std::vector<convLayer_t>& _layer, Tensor_t<int8_t> *_input, int _band) : layer(_layer), input(_input), buffer(_layer.size(), NULL),
+			band(_band), live(0), maxLive(0) {
+		const convLayer_t& last = layer.back();
+		output = new Tensor_t<int8_t>(last.OW, last.OH, last.C, input->layout());
+
+		// A band of layer l reads at most (band - 1) * stride + KHe rows of its input, and the rows below the band's window
+		// are trimmed before the next band. Its input rows are produced "band" at a time, so the last band produced for a
+		// window can reach up to band - 1 rows past it. With a stride wider than the filter, the up to stride - KHe rows
+		// between two windows are produced too (the trim can't drop rows not produced yet), which makes a window's rows
+		// at most (band - 1) * stride + stride.
+		for (size_t l = 1; l < layer.size(); l++) {
+			const convLayer_t& L = layer[l];
+			int capacity = std::min(L.H, (band - 1) * L.params.strideH + std::max(L.KHe(), L.params.strideH) + band - 1);
+			buffer[l] = new bandBuffer_t(L.W, L.D, capacity, input->layout());
+			live += buffer[l]->storage.size();
+		}
+		maxLive = live;
+	}
+
+	~fusedRun_t() {
+		for (size_t l = 1; l < buffer.size(); l++)
+			delete buffer[l];
+	}
+
+	// make level "level" hold its rows up to "need" - 1
+	void ensure(int level, int need) {
+		const convLayer_t& P = layer[level - 1];
+		while (buffer[level]->hi < need) {
+			int j0 = buffer[level]->hi;
+			produce(level, j0, std::min(j0 + band, P.OH));
+		}
+	}
+
+	// compute rows [j0, j1) of level "level" (the output of layer level - 1)
+	void produce(int level, int j0, int j1) {
+		const convLayer_t& L = layer[level - 1];
+		conv2DGeometry_t geom(L.W, L.H, L.KW, L.KH, L.params);
+		int inLo = std::max(geom.originH(j0), 0);
+		int inHi = std::min(geom.originH(j1 - 1) + L.KHe(), L.H);
+		bandBuffer_t *in = level > 1 ? buffer[level - 1] : NULL;
+		Tensor_t<int8_t> *rows = input;
+
+		// the input rows under the band
+		if (in) {
+			ensure(level - 1, inHi);
+			assert(in->lo <= inLo && in->hi >= inHi);
+			rows = in->tensor();
+		}
+		convBand_t rowBand(j0, j1, in ? in->lo : 0, L.H);
+		Tensor_t<int8_t> *out = simulatedConv2D(rows, L.filtSet, L.params, L.packed, &count, &L.epilogue, &rowBand);
+		if (in)
+			delete rows;
+		counters += count;
+		if (level < (int) layer.size())						// like run(), the network output isn't intermediate memory
+			live += out->length();
+		maxLive = std::max(maxLive, live);
+
+		// keep the band, or store it in the output
+		if (level < (int) layer.size())
+			buffer[level]->append(*out);
+		else if (output->layout() == TENSOR_LAYOUT_HWC)
+			memcpy(&(*output)(0, j0, 0), &(*out)(0, 0, 0), (size_t) out->length());
+		else
+			for (int k = 0; k < out->depth(); k++)
+				memcpy(&(*output)(0, j0, k), &(*out)(0, 0, k), (size_t) out->width() * out->height());
+		if (level < (int) layer.size())
+			live -= out->length();
+		delete out;
+
+		// rows below the next band's window are done
+		if (in && j1 < L.OH)
+			in->trim(std::min(std::max(geom.originH(j1), 0), in->hi));
+	}
+};
+
+// fused: the last layer's output is produced "band" rows at a time, pulling rows through the layers below on demand
+Tensor_t<int8_t> *convNetwork_t::runFused(Tensor_t<int8_t> *input, int band, size_t *peak, hwMMcounters_t *counters) const {
+	fusedRun_t run(layer, input, band < 1 ? 1 : band);
+	int L = (int) layer.size();
+
+	for (int j0 = 0; j0 < layer.back().OH; j0 += run.band)
+		run.produce(L, j0, std::min(j0 + run.band, layer.back().OH));
+	if (peak)
+		*peak = run.maxLive;
+	if (counters)
+		*counters = run.counters;
+	return run.output;
+}
+
+// exact reference: int32 sums (saturated per multiplier step for HWMM_ACC_SAT8) through each layer's epilogue
+Tensor_t<int8_t> *convNetwork_t::reference(const Tensor_t<int8_t> *input) const {
+	const Tensor_t<int8_t> *act = input;
+
+	for (size_t l = 0; l < layer.size(); l++) {
+		const convLayer_t& L = layer[l];
+		Tensor_t<int32_t> *exact = referenceConv2DExact(act, L.filtSet, L.params, L.epilogue.accum == HWMM_ACC_SAT8 ? hwMM.P : 0, L.packed->groupsPerTile());
+		Tensor_t<int8_t> *out = new Tensor_t<int8_t>(L.OW, L.OH, L.C, act->layout());
+		for (int k = 0; k < L.C; k++)
+			for (int j = 0; j < L.OH; j++)
+				for (int i = 0; i < L.OW; i++)
+					(*out)(i, j, k) = L.epilogue.apply((*exact)(i, j, k), k);
+		delete exact;
+		if (act != input)
+			delete act;
+		act = out;
+	}
+	return const_cast<Tensor_t<int8_t> *>(act);
+}
+
+// generate a string describing layer "l"
+std::string convNetwork_t::operator() (int l) const {
+	std::ostringstream buffer;
+	const convLayer_t& L = layer[l];
+	buffer << L.W << "x" << L.H << "x" << L.D << " by " << L.C << " of " << L.KW << "x" << L.KH << "x" << L.KD() << ", " << L.params() << ", " <<
+			L.epilogue.activationName() << " -> " << L.OW << "x" << L.OH << "x" << L.C;
+	return buffer.str();
+}
+
+// count differing elements of two tensors of the same shape
+static long countDifferences(const Tensor_t<int8_t> *a, const Tensor_t<int8_t> *b) {
+	long diffs = 0;
+	for (int k = 0; k < a->depth(); k++)
+		for (int j = 0; j < a->height(); j++)
+			for (int i = 0; i < a->width(); i++)
+				diffs += (*a)(i, j, k) != (*b)(i, j, k);
+	return diffs;
+}
+
+// networkTrial: run the network described in "file" on random input, unfused and fused (option_band rows per band),
+// and report the peak intermediate memory and simulation time of each, whether they agree, and (unless option_reference
+// is float only) the bit for bit check against the exact reference. The seed is option_seed, or random if 0.
+// "ofile" receives the network output as csv.
+void networkTrial(const char *file, const char *ofile) {
+	std::ifstream is(file);
+	convNetwork_t net;
+	std::string error;
+	Timer unfusedTimer, fusedTimer;
+	size_t unfusedPeak, fusedPeak;
+	hwMMcounters_t unfusedCounters, fusedCounters;
+
+	if (!is) {
+		perror(file);
+		return;
+	}
+	if (!net.parse(is, error)) {
+		std::cerr << file << ": " << error << std::endl;
+		return;
+	}
+
+	// random filters and input
+	std::random_device rd;
+	unsigned seed = option_seed ? (unsigned) option_seed : (rd() & 0x3fffffff) + 1;
+	std::seed_seq seq{seed};
+	std::mt19937 gen(seq);
+	std::uniform_int_distribution<> randData(-option_maxInt, option_maxInt);
+	net.setup(gen);
+	Tensor_t<int8_t> *input = new Tensor_t<int8_t>(net.width(), net.height(), net.depth(), (tensorLayout_t) option_layout);
+	for (int k = 0; k < net.depth(); k++)
+		for (int j = 0; j < net.height(); j++)
+			for (int i = 0; i < net.width(); i++)
+				(*input)(i, j, k) = randData(gen);
+
+	// both ways
+	unfusedTimer.start();
+	Tensor_t<int8_t> *unfused = net.run(input, &unfusedPeak, &unfusedCounters);
+	unfusedTimer.stop();
+	fusedTimer.start();
+	Tensor_t<int8_t> *fused = net.runFused(input, option_band, &fusedPeak, &fusedCounters);
+	fusedTimer.stop();
+
+	// report
+	std::cout << "network " << file << ": " << net.layers() << " layers, seed " << seed << std::endl;
+	for (int l = 0; l < net.layers(); l++)
+		std::cout << "  layer " << l << ": " << net(l) << std::endl;
+	std::cout.precision(3);
+	std::cout << "unfused: " << unfusedPeak << " bytes peak intermediate memory, " << unfusedTimer().c_str() << " sim time" << std::endl;
+	if (option_counters)
+		std::cout << "  HW counters: " << unfusedCounters() << std::endl;
+	long diffs = countDifferences(fused, unfused);
+	std::cout << "fused, " << std::max(option_band, 1) << " row bands: " << fusedPeak << " bytes peak intermediate memory (" <<
+			(unfusedPeak ? 100.0 * fusedPeak / unfusedPeak : 100.0) << "% of unfused), " << fusedTimer().c_str() << " sim time, ";
+	if (diffs)
+		std::cout << diffs << " differences from unfused" << std::endl;
+	else
+		std::cout << "identical to unfused" << std::endl;
+	if (option_counters)
+		std::cout << "  HW counters: " << fusedCounters() << std::endl;
+	if (option_reference != CONV_REF_FLOAT) {
+		Tensor_t<int8_t> *expected = net.reference(input);
+		long mismatches = countDifferences(unfused, expected);
+		std::cout << "exact reference: ";
+		if (mismatches)
+			std::cout << mismatches << " mismatches" << std::endl;
+		else
+			std::cout << "bit exact" << std::endl;
+		delete expected;
+	}
+
+	// if diagnostic math dump requested
+	if (ofile) {
+		CsvWriter_t dump(ofile);
+		if (dump.ok())
+			fused->csvDump(dump, "networkOutputTensor");
+		else
+			perror(ofile);
+	}
+
+	delete fused;
+	delete unfused;
+	delete input;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file network.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief multi-layer conv networks: a text description, and unfused or fused (row band) execution on the simulated HW multiplier.
+ */
+#ifndef _NETWORK_H_
+#define _NETWORK_H_
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include "tensor.h"
+#include "conv.h"
+#include "packed.h"
+#include "counters.h"
+#include "epilogue.h"
+
+// convLayer_t: one conv layer of a network. Its input is the output of the previous layer (or the network input).
+struct convLayer_t {
+	int W, H, D;						// input shape
+	int C, KW, KH;						// C filters of KW x KH x KD()
+	conv2DParams_t params;
+	int activation;						// hwMMactivation_t applied on writeback
+	int OW, OH;							// output face; the output is OW x OH x C
+	TensorArray_t<int8_t> *filtSet;		// filters, packed filters and epilogue; made by convNetwork_t::setup()
+	PackedFilters_t<int8_t> *packed;
+	hwMMepilogue_t epilogue;
+
+	convLayer_t() : W(0), H(0), D(0), C(0), KW(0), KH(0), activation(HWMM_ACT_NONE), OW(0), OH(0), filtSet(NULL), packed(NULL) {}
+
+	// filter depth: one group of the input channels
+	inline int KD() const { return D / params.groups; }
+
+	// effective (dilated) filter height
+	inline int KHe() const { return (KH - 1) * params.dilationH + 1; }
+
+	// bytes of the layer output
+	inline size_t outputBytes() const { return (size_t) OW * OH * C; }
+};
+
+// convNetwork_t: a chain of conv layers, read from a text description with one statement per line ('#' starts a comment):
+//
+//		input <W> <H> <D>
+//		conv <C> <KW>x<KH> [stride <s>] [dilation <d>] [groups <g> | depthwise] [valid | same] [none | relu | relu6 | clamp]
+//
+// "input" comes first; each "conv" adds a layer of C filters (defaults: stride 1, no dilation, one group, VALID, no 
+// activation; depthwise is one group per input channel; clamp uses --clampMin/--clampMax). Filters are random, and each layer's epilogue is calibrated for its filters and
+// the spread of its input (see setup()).
+//
+// run() executes layer by layer, so every intermediate tensor exists in full. runFused() produces the last layer's output
+// in bands of rows; a band of layer k + 1 is computed as soon as the rows of layer k under it exist, so each intermediate
+// lives only in a bounded buffer holding the rows still needed (see bandBuffer_t in network.cpp). Both give the same output.
+class convNetwork_t {
+public:
+	convNetwork_t() : W(0), H(0), D(0) {}
+	virtual ~convNetwork_t();
+
+	// not copyable: the network owns the filters and packed filters of its layers
+	convNetwork_t(const convNetwork_t&) = delete;
+	convNetwork_t& operator= (const convNetwork_t&) = delete;
+
+	// read a description; false (with the reason in "error") on a syntax error or a layer with no output
+	bool parse(std::istream& is, std::string& error);
+
+	// generate the filters and epilogues of all layers
+	void setup(std::mt19937& gen);
+
+	// execute on "input" (W x H x D); "peak" receives the peak bytes of intermediate tensors alive at one time and
+	// "counters" the HW counters of all layers
+	Tensor_t<int8_t> *run(Tensor_t<int8_t> *input, size_t *peak = NULL, hwMMcounters_t *counters = NULL) const;
+	Tensor_t<int8_t> *runFused(Tensor_t<int8_t> *input, int band, size_t *peak = NULL, hwMMcounters_t *counters = NULL) const;
+
+	// execute with the exact int32 reference convolution and the epilogue of each layer; bit for bit the expected output
+	Tensor_t<int8_t> *reference(const Tensor_t<int8_t> *input) const;
+
+	// accessors
+	inline int width() const { return W; }
+	inline int height() const { return H; }
+	inline int depth() const { return D; }
+	inline int layers() const { return (int) layer.size(); }
+	inline const convLayer_t& operator[] (int l) const { return layer[l]; }
+
+	// generate a string describing layer "l"
+	std::string operator() (int l) const;
+
+private:
+	int W, H, D;						// input shape
+	std::vector<convLayer_t> layer;
+};
+
+#endif // _NETWORK_H_
@@ -0,0 +1,178 @@
+/**
+ * @file packed.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief pre-packed, tile-major filter sets for the HW multiplier.
+ */
+#ifndef _PACKED_H_
+#define _PACKED_H_
+#include <assert.h>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <string>
+#include "tensor.h"
+
+// groups of a grouped convolution with Cg filters per group that share one P x P tile: with packing, as many whole 
+// groups as fit in the P columns; otherwise (or if a group has P or more filters) one
+inline int packedGroupsPerTile(int G, int Cg, int P, bool pack) {
+	int m = pack && Cg < P ? P / Cg : 1;
+	return m < G ? m : G;
+}
+
+// PackedFilters_t class
+// A filter set laid out once in the order the HW multiplier consumes it. Filters are grouped in channel tiles of P
+// filters; each serialized filter is cut in P-sized slices. Tile (ct, sl) is a contiguous, zero-padded P x P block whose
+// row p holds slice sl of serialized filter "ct * P + p". The packed form only depends on the filter set, P and the grouping, so it
+// can be built once and reused by every simulatedConv2D() call on a layer whose weights don't change.
+//
+// For a grouped convolution (G groups of Cg = C / G filters of length ILg, see conv2DParams_t), a channel tile covers
+// either part of one group, or, when groups are packed, m = packedGroupsPerTile() whole groups g0 .. g0 + m - 1 side by
+// side. The input vectors of such a tile are the serialized activation window over the m groups' channels, which holds
+// their inputs back to back, and the tile's filter p is its own weights at its group's place in that window and zeros
+// elsewhere (the tiles are block diagonal). Slicing the window in P-sized pieces fills the multiplier's columns with m
+// groups' filters and its depth with their inputs, where one group per tile of a depthwise layer uses a single column
+// and KW * KH of P elements. tileInputChannel(), tileInputDepth() and tileLength() give the window of a channel tile,
+// tileChannel() and tileChannels() its filters. Groups are only packed for channel first filter sets: serialized channel
+// last, the window over several groups interleaves their channels at every position, so no group is a run of it.
+//
+// The set is stored block sparse: with "compress", tiles that are all zero (pruned weights, or the off-diagonal part of
+// packed groups) are dropped, and each channel tile keeps the list of its remaining tiles. The simulator only loads,
+// gathers for and multiplies those, which is exact since an all-zero tile adds nothing to any accumulator.
+template <typename T>
+class PackedFilters_t {
+public:
+	// Constructor: pack a filter set for a P x P multiplier; "groups" as in conv2DParams_t, "pack" to share tiles between groups,
+	// "compress" to drop all-zero tiles
+	PackedFilters_t(TensorArray_t<T>& filtSet, int _P, int _groups = 1, bool pack = true, bool compress = true) : P(_P), C(filtSet.count()), 
+			W(filtSet.width()), H(filtSet.height()), D(filtSet.depth()), len(filtSet.length()), G(_groups), Cg(C / _groups), 
+			M(packedGroupsPerTile(_groups, C / _groups, _P, pack && filtSet.layout() == TENSOR_LAYOUT_CHW)), TG((Cg + _P - 1) / _P), CT(M > 1 ? (G + M - 1) / M : G * TG), 
+			SL((M * len + _P - 1) / _P), blockStart(CT + 1), blockIndex(CT * SL, -1) {
+		assert(G >= 1 && C % G == 0);
+		std::vector<T> dense((size_t) CT * SL * P * P);
+
+		// lay out every tile
+		for (int c = 0; c < C; c++) {
+			const T *src = filtSet.buffer() + c * filtSet.stride();
+			int g = c / Cg;
+			int ct = M > 1 ? g / M : g * TG + (c % Cg) / P;
+			int p = c - tileChannel(ct);
+			int v0 = (g - firstGroup(ct)) * len;				// offset of the filter in the tile's window range
+			for (int l = 0; l < len; l++) {
+				int v = v0 + l;
+				dense[(((ct * SL) + v / P) * P + p) * P + v % P] = src[l];
+			}
+		}
+
+		// keep the tiles within each channel tile's window, except all-zero ones when compressing
+		denseBlocks = 0;
+		for (int ct = 0; ct < CT; ct++) {
+			blockStart[ct] = slice.size();
+			denseBlocks += tileSlices(ct);
+			for (int sl = 0; sl < tileSlices(ct); sl++) {
+				const T *t = &dense[((ct * SL) + sl) * P * P];
+				if (!compress || std::any_of(t, t + P * P, [](T w) { return w != 0; })) {
+					blockIndex[ct * SL + sl] = slice.size();
+					slice.push_back(sl);
+				}
+			}
+		}
+		blockStart[CT] = slice.size();
+		data.resize(slice.size() * P * P);
+		for (int ct = 0; ct < CT; ct++)
+			for (int b = blockStart[ct]; b < blockStart[ct + 1]; b++)
+				memcpy(&data[b * P * P], &dense[((ct * SL) + slice[b]) * P * P], P * P * sizeof(T));
+	}
+
+	// Destructor
+	virtual ~PackedFilters_t() {}
+
+	// pointer to the P x P tile for channel tile ct and slice sl (window offsets sl*P ..); NULL for a dropped all-zero tile
+	inline const T* tile(int ct, int sl) const {
+		assert(ct >= 0 && ct < CT && sl >= 0 && sl < SL);
+		int b = blockIndex[ct * SL + sl];
+		return b < 0 ? NULL : &data[b * P * P];
+	}
+
+	// the stored tiles of channel tile ct are blocks [firstBlock(ct), endBlock(ct)), in slice order; block b is the tile
+	// of slice blockSlice(b)
+	inline int firstBlock(int ct) const { return blockStart[ct]; }
+	inline int endBlock(int ct) const { return blockStart[ct + 1]; }
+	inline int blockSlice(int b) const { return slice[b]; }
+	inline const T* block(int b) const { return &data[b * P * P]; }
+
+	// slices of channel tile ct, stored or not
+	inline int tileSlices(int ct) const { return (tileLength(ct) + P - 1) / P; }
+
+	// filters of channel tile ct: tileChannels(ct) filters from tileChannel(ct) on, in tileGroups(ct) groups
+	inline int tileChannel(int ct) const { return M > 1 ? ct * M * Cg : (ct / TG) * Cg + (ct % TG) * P; }
+	inline int tileChannels(int ct) const { 
+		int n = M > 1 ? tileGroups(ct) * Cg : Cg - (ct % TG) * P; 
+		return n < P ? n : P;
+	}
+	inline int tileGroups(int ct) const { return M > 1 ? (G - ct * M < M ? G - ct * M : M) : 1; }
+
+	// activation channels read by channel tile ct (tileInputDepth(ct) from tileInputChannel(ct) on), and the length of
+	// their serialized window, which is what the tile's slices cover
+	inline int tileInputChannel(int ct) const { return firstGroup(ct) * D; }
+	inline int tileInputDepth(int ct) const { return tileGroups(ct) * D; }
+	inline int tileLength(int ct) const { return tileGroups(ct) * len; }
+
+	// useful (filter, element) pairs of tile (ct, sl), the rest being padding or off the block diagonal
+	int tileWork(int ct, int sl) const {
+		int v0 = sl * P, v1 = v0 + P < tileLength(ct) ? v0 + P : tileLength(ct);
+		if (M == 1)
+			return tileChannels(ct) * (v1 - v0);
+		int work = 0;
+		for (int g = v0 / len; g * len < v1; g++)					// groups overlapping the slice
+			work += Cg * (std::min(v1, (g + 1) * len) - std::max(v0, g * len));
+		return work;
+	}
+
+	// check that the packed set was built from a filter set of this geometry for this multiplier size and grouping
+	bool matches(const TensorArray_t<T>& filtSet, int _P, int _groups = 1) const {
+		return P == _P && C == filtSet.count() && W == filtSet.width() && H == filtSet.height() && D == filtSet.depth() && G == _groups;
+	}
+
+	// dimension methods
+	inline const int dimension() const { return P; }
+	inline const int count() const { return C; }
+	inline const int length() const { return len; }
+	inline const int groups() const { return G; }
+	inline const int groupsPerTile() const { return M; }
+	inline const int channelTiles() const { return CT; }
+	inline const int slices() const { return SL; }
+	inline const int blocks() const { return slice.size(); }
+	inline const int windowBlocks() const { return denseBlocks; }		// tiles within the windows, stored or not
+
+	// generate a string with geometry info
+	std::string operator() () const {
+	   	std::ostringstream buffer;
+	    buffer << CT << " X " << SL << " X [" << P << "," << P << "]";
+	    if (blocks() < denseBlocks)
+	    	buffer << ", " << blocks() << " of " << denseBlocks << " tiles nonzero";
+	    if (G > 1)
+	    	buffer << ", " << G << " groups, " << M << " per tile";
+	    return buffer.str();
+	}
+
+private:
+	std::vector<T> data;				// the stored tiles, P * P elements each
+	const int P;
+	const int C, W, H, D;
+	const int len;
+	const int G, Cg;			// groups, filters per group
+	const int M;				// groups per tile
+	const int TG;				// channel tiles per group, without packing
+	const int CT, SL;
+	std::vector<int> blockStart;		// first stored block of each channel tile, and the total at [CT]
+	std::vector<int> blockIndex;		// stored block of each (channel tile, slice), -1 if dropped
+	std::vector<int> slice;				// slice of each stored block
+	int denseBlocks;					// tiles within the channel tiles' windows, stored or not
+
+	// first group of channel tile ct
+	inline int firstGroup(int ct) const { return M > 1 ? ct * M : ct / TG; }
+};
+
+#endif // _PACKED_H_
@@ -0,0 +1,190 @@
+/**
+ * @file reference.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief exact integer reference convolution.
+ */
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+#include <vector>
+#include <immintrin.h>
+#include "main.h"
+#include "tensor.h"
+#include "conv.h"
+#include "scheduler.h"
+#include "epilogue.h"
+
+// output channels accumulated together; CB rows of int32 accumulators stay in L1 for layer widths up to a few hundred
+static const int referenceChannelBlock = 16;
+
+// acc[i] += w * src[i], i in [0, n)
+static void axpyScalar(int32_t *acc, const int32_t *src, int32_t w, int n) {
+	for (int i = 0; i < n; i++)
+		acc[i] += w * src[i];
+}
+
+__attribute__((target("avx2")))
+static void axpyAVX2(int32_t *acc, const int32_t *src, int32_t w, int n) {
+	__m256i wv = _mm256_set1_epi32(w);
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) &acc[i]);
+		__m256i s = _mm256_loadu_si256((const __m256i *) &src[i]);
+		_mm256_storeu_si256((__m256i *) &acc[i], _mm256_add_epi32(a, _mm256_mullo_epi32(wv, s)));
+	}
+	for (; i < n; i++)
+		acc[i] += w * src[i];
+}
+
+// referenceConv2DExact: direct convolution with exact int32 sums (no 8-bit wraparound), so that hwMMepilogue_t::apply() of
+// a result element is what the simulated HW must produce bit for bit. Work units are (output row, block of output channels) 
+// and run on option_threads host threads. For each filter tap row, the activation row is widened to int32 and zero padded 
+// once, then every tap x of the row is a strided slice of it, multiply-added into all channels of the block at once 
+// (vectorized over the output row). 
+//
+// With "saturateSlice" > 0, the result instead models 8-bit saturating accumulators updated once per "saturateSlice" 
+// serialized filter elements (one multiplier step of P elements): taps are visited in serialization order, so the partial
+// sums are folded into a clamped running sum at every slice boundary. With groups packed "saturateGroups" to a multiplier
+// tile (see PackedFilters_t), the filters of the i-th group of a tile start i filter lengths into its slices.
+//
+// Channel blocks don't span groups; filters of group g read activation channels from g * filter depth on. The activations
+// and filters share a layout, which sets the serialization order of the taps; the result is always channel first.
+Tensor_t<int32_t> *referenceConv2DExact(const Tensor_t<int8_t> *act, TensorArray_t<int8_t> *filtSet, const conv2DParams_t& params, int saturateSlice, int saturateGroups) {
+	conv2DGeometry_t geom(act->width(), act->height(), filtSet->width(), filtSet->height(), params);
+	int W = act->width(), H = act->height(), D = filtSet->depth();
+	int KW = filtSet->width(), KH = filtSet->height();
+	int IL = filtSet->length();
+	int OW = geom.OW, OH = geom.OH, OC = filtSet->count();
+	int G = params.groups, CG = OC / G;					// groups, filters per group
+	int CB = referenceChannelBlock;
+	int groupBlocks = (CG + CB - 1) / CB;
+	int blocks = G * groupBlocks;
+	int PW = (OW - 1) * params.strideW + (KW - 1) * params.dilationW + 1;	// padded row span read by one output row
+	const int8_t *filters = filtSet->buffer();
+	int filterStride = filtSet->stride();
+	void (*axpy)(int32_t *, const int32_t *, int32_t, int) = __builtin_cpu_supports("avx2") ? axpyAVX2 : axpyScalar;
+	Tensor_t<int32_t> *res = new Tensor_t<int32_t>(OW, OH, OC);
+	TileScheduler_t scheduler(option_threads);
+
+	// per-thread accumulators, saturated running sums, padded activation rows and strided tap slice
+	bool hwc = act->layout() == TENSOR_LAYOUT_HWC;
+	int rows = hwc ? D : 1;										// activation rows widened at once
+	std::vector<std::vector<int32_t>> scratch(scheduler.threadCount(), std::vector<int32_t>(2 * CB * OW + rows * PW + OW));
+	assert(act->layout() == filtSet->layout());
+
+	scheduler.run(OH * blocks, [&](int unit, int thread) {
+		int j = unit / blocks;
+		int g = (unit % blocks) / groupBlocks;
+		int c0 = g * CG + (unit % groupBlocks) * CB;
+		int cn = (g + 1) * CG - c0 < CB ? (g + 1) * CG - c0 : CB;
+		int k0 = g * D;												// first activation channel of the group
+		int offset = (g % saturateGroups) * IL;						// start of the group's filters in their tiles' slices
+		int32_t *acc = scratch[thread].data();
+		int32_t *sat = &acc[CB * OW];
+		int32_t *row = &sat[CB * OW];
+		int32_t *tap = &row[rows * PW];
+
+		// widen and pad activation row jj of channel k into "dst": dst[ii] is activation column originW(0) + ii
+		auto widen = [&](int32_t *dst, int jj, int k) {
+			const int8_t *src = &(*act)(0, jj, k0 + k);
+			int step = act->columnStride();
+			for (int ii = 0; ii < PW; ii++) {
+				int a = geom.originW(0) + ii;
+				dst[ii] = (a >= 0 && a < W) ? src[a * step] : 0;
+			}
+		};
+
+		// tap (x, y, k) of the filter, serialized element f = l - 1, against every output column of the widened row "src";
+		// then fold the partial sums of a completed multiplier step into the saturating accumulators
+		auto multiplyTap = [&](const int32_t *src, bool inside, int x, int f) {
+			if (inside) {
+				const int32_t *slice = &src[x * params.dilationW];
+				if (params.strideW != 1) {
+					for (int i = 0; i < OW; i++)
+						tap[i] = slice[i * params.strideW];
+					slice = tap;
+				}
+				for (int c = 0; c < cn; c++) {
+					int32_t w = filters[(c0 + c) * filterStride + f];
+					if (w)
+						axpy(&acc[c * OW], slice, w, OW);
+				}
+			}
+			int l = f + 1;
+			if (saturateSlice > 0 && ((offset + l) % saturateSlice == 0 || l == IL))
+				for (int n = 0; n < cn * OW; n++) {
+					int32_t v = sat[n] + acc[n];
+					sat[n] = v < -128 ? -128 : (v > 127 ? 127 : v);
+					acc[n] = 0;
+				}
+		};
+
+		// taps in serialization order: (k, y, x) channel first, (y, x, k) channel last
+		for (int n = 0; n < cn * OW; n++)
+			acc[n] = sat[n] = 0;
+		if (hwc)
+			for (int y = 0; y < KH; y++) {
+				int jj = geom.originH(j) + y * params.dilationH;
+				bool inside = jj >= 0 && jj < H;
+				if (inside)
+					for (int k = 0; k < D; k++)
+						widen(&row[k * PW], jj, k);
+				for (int x = 0; x < KW; x++)
+					for (int k = 0; k < D; k++)
+						multiplyTap(&row[k * PW], inside, x, (y * KW + x) * D + k);
+			}
+		else
+			for (int k = 0; k < D; k++)
+				for (int y = 0; y < KH; y++) {
+					int jj = geom.originH(j) + y * params.dilationH;
+					bool inside = jj >= 0 && jj < H;
+					if (inside)
+						widen(row, jj, k);
+					for (int x = 0; x < KW; x++)
+						multiplyTap(row, inside, x, (k * KH + y) * KW + x);
+				}
+
+		// store the output rows of the block
+		const int32_t *sums = saturateSlice > 0 ? sat : acc;
+		for (int c = 0; c < cn; c++) {
+			int32_t *out = &(*res)(0, j, c0 + c);
+			for (int i = 0; i < OW; i++)
+				out[i] = sums[c * OW + i];
+		}
+	});
+	return res;
+}
+
+// compute the RMS error between a fixed point simulated tensor and the ideal outputs for the exact sums of a reference
+float compareTensors(Tensor_t<int8_t> *sTensor, Tensor_t<int32_t> *rTensor, const hwMMepilogue_t& epi) {
+	double error = 0.0;
+
+	int W = sTensor->width();
+	int H = sTensor->height();
+	int D = sTensor->depth();
+	assert(W == rTensor->width() && H == rTensor->height() && D == rTensor->depth());
+	for (int k = 0; k < D; k++)
+		for (int j = 0; j < H; j++)
+			for (int i = 0; i < W; i++) {
+				double diff = (double) (*sTensor)(i,j,k) - epi.ideal((*rTensor)(i,j,k), k);
+				error += diff * diff;
+			}
+	return pow(error / ((double) W * H * D), 0.5);
+}
+
+// count the simulated elements that differ from the epilogue outputs of the reference accumulators
+long countMismatches(Tensor_t<int8_t> *sTensor, Tensor_t<int32_t> *rTensor, const hwMMepilogue_t& epi) {
+	long mismatches = 0;
+
+	int W = sTensor->width();
+	int H = sTensor->height();
+	int D = sTensor->depth();
+	assert(W == rTensor->width() && H == rTensor->height() && D == rTensor->depth());
+	for (int k = 0; k < D; k++)
+		for (int j = 0; j < H; j++)
+			for (int i = 0; i < W; i++)
+				if ((*sTensor)(i,j,k) != epi.apply((*rTensor)(i,j,k), k))
+					mismatches++;
+	return mismatches;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file scheduler.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief work-stealing scheduler for independent simulation units.
+ */
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include "scheduler.h"
+
+// per-thread unit queue
+struct unitQueue_t {
+	std::mutex lock;
+	std::deque<int> units;
+};
+
+// take the next unit: own queue from the front, otherwise steal from the back of another queue. 
+// Units are never added once running, so finding every queue empty means the thread is done.
+static bool nextUnit(std::vector<unitQueue_t>& queues, int self, int& unit) {
+	int Q = queues.size();
+	for (int v = 0; v < Q; v++) {
+		unitQueue_t& q = queues[(self + v) % Q];
+		std::lock_guard<std::mutex> guard(q.lock);
+		if (q.units.empty())
+			continue;
+		if (v == 0) {
+			unit = q.units.front();
+			q.units.pop_front();
+		} else {
+			unit = q.units.back();
+			q.units.pop_back();
+		}
+		return true;
+	}
+	return false;
+}
+
+// set while this thread is a worker of some run(); a run() nested inside a unit then stays on the calling thread,
+// so e.g. parallel trials each simulating with option_threads threads do not oversubscribe the host
+static thread_local bool inWorker = false;
+
+// run "count" units on up to "threads" workers; worker(next, thread) runs the units next() hands out to the worker
+void TileScheduler_t::runWorkers(int count, const std::function<void(const std::function<bool(int&)>&, int)>& worker) const {
+	int T = threads < count ? threads : count;
+	if (inWorker)
+		T = 1;
+
+	// nothing to distribute
+	if (T <= 1) {
+		int u = 0;
+		worker([&](int& unit) { 
+			if (u >= count)
+				return false;
+			unit = u++;
+			return true;
+		}, 0);
+		return;
+	}
+
+	// deal contiguous blocks of units to the queues
+	std::vector<unitQueue_t> queues(T);
+	for (int t = 0; t < T; t++)
+		for (int u = (int) ((long) t * count / T); u < (int) ((long) (t + 1) * count / T); u++)
+			queues[t].units.push_back(u);
+
+	// start the workers; the calling thread is worker 0
+	auto run = [&](int self) {
+		bool wasWorker = inWorker;
+		inWorker = true;
+		worker([&](int& unit) { return nextUnit(queues, self, unit); }, self);
+		inWorker = wasWorker;
+	};
+	std::vector<std::thread> pool;
+	for (int t = 1; t < T; t++)
+		pool.push_back(std::thread(run, t));
+	run(0);
+	for (size_t t = 0; t < pool.size(); t++)
+		pool[t].join();
+}
+
+// run all units
+void TileScheduler_t::run(int count, const std::function<void(int, int)>& fn) const {
+	runWorkers(count, [&](const std::function<bool(int&)>& next, int thread) {
+		int unit;
+		while (next(unit))
+			fn(unit, thread);
+	});
+}
+
+// run all units in two stages
+void TileScheduler_t::run(int count, const std::function<void(int, int, int)>& produce, const std::function<void(int, int, int)>& consume) const {
+	bool serial = inWorker;
+	runWorkers(count, [&](const std::function<bool(int&)>& next, int thread) {
+		pipeline(next, thread, serial, produce, consume);
+	});
+}
+
+// run the units handed out by "next" in two stages: the producer thread fills the two buffers in turn, and the calling 
+// thread consumes them in the same order. ready[b] is the unit produced into buffer b and not consumed yet, or -1.
+void TileScheduler_t::pipeline(const std::function<bool(int&)>& next, int thread, bool serial, const std::function<void(int, int, int)>& produce, 
+		const std::function<void(int, int, int)>& consume) {
+	int unit;
+	if (serial) {
+		while (next(unit)) {
+			produce(unit, thread, 0);
+			consume(unit, thread, 0);
+		}
+		return;
+	}
+
+	std::mutex lock;
+	std::condition_variable cond;
+	int ready[2] = { -1, -1 };
+	bool done = false;
+	std::thread producer([&] {
+		int u;
+		inWorker = true;
+		for (int b = 0; next(u); b ^= 1) {
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				cond.wait(guard, [&] { return ready[b] < 0; });
+			}
+			produce(u, thread, b);
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				ready[b] = u;
+			}
+			cond.notify_all();
+		}
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			done = true;
+		}
+		cond.notify_all();
+	});
+	for (int b = 0;; b ^= 1) {
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			cond.wait(guard, [&] { return ready[b] >= 0 || done; });
+			if (ready[b] < 0)
+				break;
+			unit = ready[b];
+		}
+		consume(unit, thread, b);
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			ready[b] = -1;
+		}
+		cond.notify_all();
+	}
+	producer.join();
+}
+
+// true on a worker thread
+bool TileScheduler_t::nested() {
+	return inWorker;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file scheduler.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief work-stealing scheduler for independent simulation units.
+ */
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+#include <functional>
+
+// TileScheduler_t class
+// Runs "count" independent work units on up to "threads" host threads. Each thread starts with a contiguous block of units
+// (so neighbouring tiles, which share operand data, stay on one thread) and takes them from the front of its own queue; 
+// once that is empty it steals from the back of the other queues. The function is called as fn(unit, thread) where thread 
+// is in [0, threadCount()), so callers can keep per-thread state indexed by it. Units must write disjoint results; 
+// which thread ran a unit then has no effect on the output. A run() from inside a unit of another run() executes its
+// units serially on the calling thread.
+//
+// Units can also run in two stages, produce(unit, thread, buffer) and then consume(unit, thread, buffer): each worker 
+// thread gets a producer thread that takes the units and produces the next one into the other of two buffers while the 
+// worker consumes the current one, so a unit's inputs can be prepared while the one before is computed. The units of a 
+// worker are consumed in the order they were produced. Nested inside another run(), both stages run on the calling thread.
+class TileScheduler_t {
+public:
+	// Constructor; threads < 1 means one thread
+	TileScheduler_t(int _threads = 1) : threads(_threads < 1 ? 1 : _threads) {}
+
+	// run all units; returns when every unit has completed
+	void run(int count, const std::function<void(int, int)>& fn) const;
+
+	// run all units in two stages
+	void run(int count, const std::function<void(int, int, int)>& produce, const std::function<void(int, int, int)>& consume) const;
+
+	// run the units handed out by "next" in two stages as the worker "thread", with a producer thread unless "serial"
+	static void pipeline(const std::function<bool(int&)>& next, int thread, bool serial, const std::function<void(int, int, int)>& produce, 
+			const std::function<void(int, int, int)>& consume);
+
+	// true on a worker thread of some run()
+	static bool nested();
+
+	// dimension methods
+	inline const int threadCount() const { return threads; }
+
+private:
+	const int threads;
+
+	void runWorkers(int count, const std::function<void(const std::function<bool(int&)>&, int)>& worker) const;
+};
+
+#endif // _SCHEDULER_H_
@@ -9,71 +9,251 @@
 #include <iostream>
 #include <string>
 #include <random>
+#include <vector>
+#include <mutex>
+#include <algorithm>
 #include <sys/time.h>
 #include "main.h"
 #include "tensor.h"
+#include "arena.h"
+#include "conv.h"
+#include "counters.h"
+#include "engines.h"
+#include "epilogue.h"
+#include "packed.h"
+#include "hwmm.h"
+#include "scheduler.h"
+#include "tensorfile.h"
+#include "tune.h"
 #include "timer.h"
 
 // forward declarations
-extern Tensor_t<int8_t> *genActivation();
-extern TensorArray_t<int8_t> *genFilters(const Tensor_t<int8_t> *);
-extern Tensor_t<int8_t> *simulatedConv2D(Tensor_t<int8_t> *, TensorArray_t<int8_t> *); 
-extern Tensor_t<float> *referenceConv2D(Tensor_t<float> *, TensorArray_t<float> *);
-extern float compareTensors(Tensor_t<int8_t> *, Tensor_t<float> *);
-
-// Code to run one trial
-void conv2dTrial(const char* ofile) {
+extern Tensor_t<int8_t> *genActivation(std::mt19937 &);
+extern TensorArray_t<int8_t> *genActivations(int, std::mt19937 &);
+extern TensorArray_t<int8_t> *genFilters(const Tensor_t<int8_t> *, std::mt19937 &);
+extern void pruneFilters(TensorArray_t<int8_t> &, int, std::mt19937 &);
+extern hwMMepilogue_t genEpilogue(const TensorArray_t<int8_t> &, std::mt19937 &);
+extern Tensor_t<int8_t> *simulatedConv2D(Tensor_t<int8_t> *, TensorArray_t<int8_t> *, const conv2DParams_t & = conv2DParams_t(), const PackedFilters_t<int8_t> * = NULL, 
+		hwMMcounters_t * = NULL, const hwMMepilogue_t * = NULL, const convBand_t * = NULL); 
+extern TensorArray_t<int8_t> *simulatedConv2DBatch(TensorArray_t<int8_t> *, TensorArray_t<int8_t> *, const conv2DParams_t & = conv2DParams_t(), const PackedFilters_t<int8_t> * = NULL, 
+		hwMMcounters_t * = NULL, const hwMMepilogue_t * = NULL); 
+extern Tensor_t<float> *referenceConv2D(Tensor_t<float> *, TensorArray_t<float> *, const conv2DParams_t & = conv2DParams_t());
+extern Tensor_t<int32_t> *referenceConv2DExact(const Tensor_t<int8_t> *, TensorArray_t<int8_t> *, const conv2DParams_t & = conv2DParams_t(), int = 0, int = 1);
+extern float compareTensors(Tensor_t<int8_t> *, Tensor_t<float> *, const hwMMepilogue_t * = NULL);
+extern float compareTensors(Tensor_t<int8_t> *, Tensor_t<int32_t> *, const hwMMepilogue_t &);
+extern long countMismatches(Tensor_t<int8_t> *, Tensor_t<int32_t> *, const hwMMepilogue_t &);
+
+// outcome of one trial
+struct trialResult_t {
+	float rmsError;				// against the exact reference if one was run, else against the float reference
+	long mismatches;			// elements that differ from the 8-bit wraparound model; -1 if not checked
+	hwMMcounters_t counters;
+};
+
+// append the error part of a trial report
+static void reportErrors(std::ostream& out, const trialResult_t& result, float floatError) {
+	out << (result.rmsError * 100.0) << "% rms error";
+	if (option_reference == CONV_REF_BOTH)
+		out << " (float reference " << (floatError * 100.0) << "%)";
+	if (result.mismatches == 0)
+		out << ", bit exact";
+	else if (result.mismatches > 0)
+		out << ", " << result.mismatches << " mismatches";
+}
+
+// open a tensor file of int8 data, or print why not
+static bool openTrialFile(TensorFile_t& file, const char *path) {
+	std::string error;
+	if (!file.open(path, error)) {
+		std::cerr << error << std::endl;
+		return false;
+	}
+	if (!file.holds<int8_t>()) {
+		std::cerr << path << ": not int8 data" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// groups of a trial convolution on D activation channels (option_groups; 0 = depthwise)
+static int trialGroups(int D) {
+	return option_groups ? option_groups : D;
+}
+
+// checkTrialFiles: check the tensor files given for the trials (--activations, --filters) before any trial runs, and fit
+// the options to them: an activation file of N > 1 tensors is one batch (option_batch = N), and random activations for a 
+// filter file get the depth of its groups (with depthwise filters, one channel per filter) and are at least as large as 
+// its (dilated) filters. Returns false, with a message, on an error.
+bool checkTrialFiles() {
+	TensorFile_t activationFile, filterFile;
+
+	if (option_activationFile) {
+		if (!openTrialFile(activationFile, option_activationFile))
+			return false;
+		if (activationFile.depth() % trialGroups(activationFile.depth())) {
+			std::cerr << option_activationFile << ": depth isn't a multiple of " << option_groups << " groups" << std::endl;
+			return false;
+		}
+		option_batch = activationFile.count();
+	}
+	if (option_filterFile) {
+		if (!openTrialFile(filterFile, option_filterFile))
+			return false;
+		int D = option_activationFile ? activationFile.depth() : (option_groups ? filterFile.depth() * option_groups : filterFile.count());
+		int G = trialGroups(D);
+		int KWe = (filterFile.width() - 1) * option_dilation + 1;
+		int KHe = (filterFile.height() - 1) * option_dilation + 1;
+		if (D != filterFile.depth() * G || filterFile.count() % G) {
+			std::cerr << option_filterFile << ": filters don't fit " << G << " groups of the activation channels" << std::endl;
+			return false;
+		}
+		if (option_activationFile) {
+			if (option_padding == CONV_PAD_VALID && (activationFile.width() < KWe || activationFile.height() < KHe)) {
+				std::cerr << option_filterFile << ": filters don't fit the activations in " << option_activationFile << std::endl;
+				return false;
+			}
+		} else {
+			option_minD = option_maxD = D;
+			option_minW = std::max(option_minW, KWe); option_maxW = std::max(option_maxW, option_minW);
+			option_minH = std::max(option_minH, KHe); option_maxH = std::max(option_maxH, option_minH);
+		}
+	}
+	return true;
+}
+
+// map a tensor file checked by checkTrialFiles()
+static TensorFile_t *mapTrialFile(TensorFile_t& file, const char *path) {
+	std::string error;
+	bool ok = file.open(path, error);
+	assert(ok);
+	(void) ok;
+	return &file;
+}
+
+// tensors read from files are converted to the layout of the trial (option_layout) if they were saved in another one
+template <typename T>
+static T *inTrialLayout(T *t) {
+	if (t->layout() == (tensorLayout_t) option_layout)
+		return t;
+	T *converted = new T(*t, (tensorLayout_t) option_layout);
+	delete t;
+	return converted;
+}
+
+// write the inputs and result of a trial to tensor files "<option_save>_activations.tensor", "<option_save>_filters.tensor"
+// and "<option_save>_result.tensor"; the first two replay the trial through --activations and --filters
+template <typename T>
+static void saveTrial(const T& activations, const TensorArray_t<int8_t>& filtSet, const T& result) {
+	std::string prefix(option_save), error;
+	if (!TensorFile_t::write((prefix + "_activations.tensor").c_str(), activations, error) ||
+			!TensorFile_t::write((prefix + "_filters.tensor").c_str(), filtSet, error) ||
+			!TensorFile_t::write((prefix + "_result.tensor").c_str(), result, error))
+		std::cerr << error << std::endl;
+}
+
+// open the diagnostic math dump "ofile" (NULL if none was asked for or it can't be created); it is written by a background
+// thread as it is formatted, and through gzip if the name ends in ".gz"
+static CsvWriter_t *openDump(const char *ofile) {
+	if (ofile == NULL)
+		return NULL;
+	CsvWriter_t *dump = new CsvWriter_t(ofile, true);
+	if (!dump->ok()) {
+		perror(ofile);
+		delete dump;
+		dump = NULL;
+	}
+	return dump;
+}
+
+// Code to run one trial; all random data comes from "seed", so a trial is replayed with --seed <seed> --trials 1.
+// Its report is written to "out".
+trialResult_t conv2dTrial(unsigned seed, const char* ofile, std::ostream& out) {
    	Timer timer;
    	Tensor_t<int8_t> *simulatedActivationTensor, *simulatedResultTensor;
    	TensorArray_t<int8_t> *simulatedFilterSet; 
-   	Tensor_t<float> *referenceActivationTensor, *referenceResultTensor;
-   	TensorArray_t<float> *referenceFilterSet; 
-   	float rmsError;
-   	static std::ostringstream buffer;
+   	Tensor_t<float> *referenceActivationTensor = NULL, *referenceResultTensor = NULL;
+   	TensorArray_t<float> *referenceFilterSet = NULL; 
+   	Tensor_t<int32_t> *exactResultTensor = NULL;
+   	TensorFile_t activationFile, filterFile;			// inputs read from files, if given
+   	trialResult_t result;
+   	float floatError = 0.0;
+   	std::ostringstream buffer;
+   	std::seed_seq seq{seed};
+   	std::mt19937 gen(seq);
+   	conv2DParams_t params(option_stride, option_stride, option_dilation, option_dilation, option_padding);
+   	int groupsPerTile;
+   	Arena_t arena;
+   	ArenaScope_t scope(option_arena ? &arena : NULL);		// tensors of this trial live in the arena
   
     timer.start(); {
-    	// generate simulated and reference data sets
-		simulatedActivationTensor = genActivation();
-		simulatedFilterSet = genFilters(simulatedActivationTensor);
-		referenceActivationTensor = new Tensor_t<float>(*simulatedActivationTensor); 
-		referenceFilterSet = new TensorArray_t<float>(*simulatedFilterSet);
+    	// generate simulated data set, and the float copy if the float reference runs
+		simulatedActivationTensor = option_activationFile ? inTrialLayout(mapTrialFile(activationFile, option_activationFile)->tensor<int8_t>(0)) : genActivation(gen);
+		simulatedFilterSet = option_filterFile ? inTrialLayout(mapTrialFile(filterFile, option_filterFile)->array<int8_t>()) : genFilters(simulatedActivationTensor, gen);
+		hwMMepilogue_t epilogue = genEpilogue(*simulatedFilterSet, gen);
+		params.groups = trialGroups(simulatedActivationTensor->depth());
+		groupsPerTile = packedGroupsPerTile(params.groups, simulatedFilterSet->count() / params.groups, hwMM.P, option_groupPack && simulatedFilterSet->layout() == TENSOR_LAYOUT_CHW);
+		if (option_reference != CONV_REF_INT) {
+			referenceActivationTensor = new Tensor_t<float>(*simulatedActivationTensor); 
+			referenceFilterSet = new TensorArray_t<float>(*simulatedFilterSet);
+		}
 		buffer << (*simulatedActivationTensor)().c_str() << " by " << (*simulatedFilterSet)().c_str();
+		if (!params.isDefault())
+			buffer << ", " << params();
 
 		// if verbose, compare input tensors
-		if (option_verbose) {
-			float actError, filterError;
+		if (option_verbose && referenceActivationTensor) {
+			float actError, filterError = 0.0;
 
 			actError = compareTensors(simulatedActivationTensor, referenceActivationTensor);
 			for (int n = 0; n < simulatedFilterSet-> count(); n++) {
 				float ferr = compareTensors(simulatedFilterSet->pointer(n), referenceFilterSet->pointer(n));
 				if (ferr > filterError) filterError = ferr;
 			}
-			std::cout.precision(2);
-			std::cout << "Activation tensor diff = " << actError << ", max filter error = " << filterError << std::endl;
+			out.precision(2);
+			out << "Activation tensor diff = " << actError << ", max filter error = " << filterError << std::endl;
+		}
+
+		// simulate and generate refernce results; a requested math dump streams out the simulated result while the references run
+		simulatedResultTensor = simulatedConv2D(simulatedActivationTensor, simulatedFilterSet, params, NULL, &result.counters, &epilogue);
+		CsvWriter_t *dump = openDump(ofile);
+		if (dump) {
+	 		// simulatedActivationTensor->csvDump(*dump, "simulatedActivationTensor");
+			// referenceActivationTensor->csvDump(*dump, "referenceActivationTensor");
+			// simulatedFilterSet->csvDump(*dump, "simulatedFilterSet");
+			// referenceFilterSet->csvDump(*dump, "referenceFilterSet");
+			simulatedResultTensor->csvDump(*dump, "simulatedResultTensor");
+		}
+		if (referenceActivationTensor)
+			referenceResultTensor = referenceConv2D(referenceActivationTensor, referenceFilterSet, params);
+		if (option_reference != CONV_REF_FLOAT)
+			exactResultTensor = referenceConv2DExact(simulatedActivationTensor, simulatedFilterSet, params);
+
+		// compare; errors are against ideal outputs, the bit for bit check against the modeled accumulators
+		if (referenceResultTensor)
+			floatError = compareTensors(simulatedResultTensor, referenceResultTensor, &epilogue);
+		if (exactResultTensor) {
+			result.rmsError = compareTensors(simulatedResultTensor, exactResultTensor, epilogue);
+			if (epilogue.accum == HWMM_ACC_SAT8) {
+				Tensor_t<int32_t> *saturatedResultTensor = referenceConv2DExact(simulatedActivationTensor, simulatedFilterSet, params, hwMM.P, groupsPerTile);
+				result.mismatches = countMismatches(simulatedResultTensor, saturatedResultTensor, epilogue);
+				delete saturatedResultTensor;
+			} else
+				result.mismatches = countMismatches(simulatedResultTensor, exactResultTensor, epilogue);
+		} else {
+			result.rmsError = floatError;
+			result.mismatches = -1;
 		}
 
-		// simulate and generate refernce results
-		simulatedResultTensor = simulatedConv2D(simulatedActivationTensor, simulatedFilterSet);
-		referenceResultTensor = referenceConv2D(referenceActivationTensor, referenceFilterSet);
-
-		// compare
-	 	rmsError = compareTensors(simulatedResultTensor, referenceResultTensor);
-
-	 	// if diagnostic math dump requested
-	 	if (ofile) {
-	 		std::filebuf fb;
-	 		if (fb.open(ofile, std::ios::out)) {
-	 			std::ostream os(&fb);
-	 		// 	simulatedActivationTensor->csvDump(os, "simulatedActivationTensor");
-				// referenceActivationTensor->csvDump(os, "referenceActivationTensor");
-				// simulatedFilterSet->csvDump(os, "simulatedFilterSet");
-				// referenceFilterSet->csvDump(os, "referenceFilterSet");
-				simulatedResultTensor->csvDump(os, "simulatedResultTensor");
-				referenceResultTensor->csvDump(os, "referenceResultTensor");
-				fb.close();
-	 		} else
-	 			perror(ofile);
+	 	// finish the diagnostic math dump
+	 	if (dump) {
+			if (referenceResultTensor)
+				referenceResultTensor->csvDump(*dump, "referenceResultTensor");
+			if (exactResultTensor)
+				exactResultTensor->csvDump(*dump, "exactResultTensor");
+			delete dump;
 	 	}
+	 	if (option_save && option_trials == 1)
+	 		saveTrial(*simulatedActivationTensor, *simulatedFilterSet, *simulatedResultTensor);
 
 	 	// cleanup
 		delete simulatedActivationTensor;
@@ -82,22 +262,192 @@ void conv2dTrial(const char* ofile) {
 		delete referenceActivationTensor;
 		delete referenceFilterSet;
 		delete referenceResultTensor;
+		delete exactResultTensor;
 	} timer.stop();
 
 	// print results
+	out.precision(2);
+	out << "conv2D trial: " << buffer.str() << ", ";
+	reportErrors(out, result, floatError);
+	out << ", " << timer().c_str() << " sim time, seed " << seed << std::endl; 
+	if (option_counters)
+		out << "HW counters: " << result.counters() << std::endl;
+	if (option_verbose && option_arena)
+		out << "Arena memory: " << arena.peak() << " bytes peak in trial, " << Arena_t::peakReserved() << " bytes peak reserved" << std::endl;
+	return result;
+}
+
+// Code to run one batched trial: option_batch activation tensors of the same shape through one filter set
+trialResult_t conv2dBatchTrial(unsigned seed, const char* ofile, std::ostream& out) {
+   	Timer timer;
+   	TensorArray_t<int8_t> *simulatedActivationSet, *simulatedResultSet;
+   	TensorArray_t<int8_t> *simulatedFilterSet; 
+   	TensorArray_t<float> *referenceActivationSet = NULL;
+   	TensorArray_t<float> *referenceFilterSet = NULL; 
+   	std::vector<Tensor_t<float> *> referenceResultSet;
+   	std::vector<Tensor_t<int32_t> *> exactResultSet;
+   	TensorFile_t activationFile, filterFile;			// inputs read from files, if given
+   	trialResult_t result;
+   	float floatError = 0.0;
+   	double exactError = 0.0;
+   	std::ostringstream buffer;
+   	std::seed_seq seq{seed};
+   	std::mt19937 gen(seq);
+   	conv2DParams_t params(option_stride, option_stride, option_dilation, option_dilation, option_padding);
+   	int groupsPerTile;
+   	Arena_t arena;
+   	ArenaScope_t scope(option_arena ? &arena : NULL);		// tensors of this trial live in the arena
+  
+    timer.start(); {
+    	// generate simulated data set, and the float copy if the float reference runs
+		simulatedActivationSet = option_activationFile ? inTrialLayout(mapTrialFile(activationFile, option_activationFile)->array<int8_t>()) : genActivations(option_batch, gen);
+		simulatedFilterSet = option_filterFile ? inTrialLayout(mapTrialFile(filterFile, option_filterFile)->array<int8_t>()) : genFilters(simulatedActivationSet->pointer(0), gen);
+		hwMMepilogue_t epilogue = genEpilogue(*simulatedFilterSet, gen);
+		params.groups = trialGroups(simulatedActivationSet->depth());
+		groupsPerTile = packedGroupsPerTile(params.groups, simulatedFilterSet->count() / params.groups, hwMM.P, option_groupPack && simulatedFilterSet->layout() == TENSOR_LAYOUT_CHW);
+		if (option_reference != CONV_REF_INT) {
+			referenceActivationSet = new TensorArray_t<float>(*simulatedActivationSet); 
+			referenceFilterSet = new TensorArray_t<float>(*simulatedFilterSet);
+		}
+		buffer << (*simulatedActivationSet)().c_str() << " by " << (*simulatedFilterSet)().c_str();
+		if (!params.isDefault())
+			buffer << ", " << params();
+
+		// simulate the whole batch; generate reference results image by image
+		simulatedResultSet = simulatedConv2DBatch(simulatedActivationSet, simulatedFilterSet, params, NULL, &result.counters, &epilogue);
+		CsvWriter_t *dump = openDump(ofile);
+		if (dump)
+			simulatedResultSet->csvDump(*dump, "simulatedResultSet");
+		for (int b = 0; b < option_batch; b++) {
+			if (referenceActivationSet)
+				referenceResultSet.push_back(referenceConv2D(referenceActivationSet->pointer(b), referenceFilterSet, params));
+			if (option_reference != CONV_REF_FLOAT)
+				exactResultSet.push_back(referenceConv2DExact(simulatedActivationSet->pointer(b), simulatedFilterSet, params));
+		}
+
+		// compare; all results have the same size, so the batch rms error is the rms of the per-image errors
+		result.mismatches = exactResultSet.empty() ? -1 : 0;
+		for (int b = 0; b < (int) referenceResultSet.size(); b++)
+			floatError += pow(compareTensors(simulatedResultSet->pointer(b), referenceResultSet[b], &epilogue), 2.0);
+		floatError = pow(floatError / option_batch, 0.5);
+		for (int b = 0; b < (int) exactResultSet.size(); b++) {
+			exactError += pow(compareTensors(simulatedResultSet->pointer(b), exactResultSet[b], epilogue), 2.0);
+			if (epilogue.accum == HWMM_ACC_SAT8) {
+				Tensor_t<int32_t> *saturatedResultTensor = referenceConv2DExact(simulatedActivationSet->pointer(b), simulatedFilterSet, params, hwMM.P, groupsPerTile);
+				result.mismatches += countMismatches(simulatedResultSet->pointer(b), saturatedResultTensor, epilogue);
+				delete saturatedResultTensor;
+			} else
+				result.mismatches += countMismatches(simulatedResultSet->pointer(b), exactResultSet[b], epilogue);
+		}
+		result.rmsError = exactResultSet.empty() ? floatError : pow(exactError / option_batch, 0.5);
+
+	 	// finish the diagnostic math dump
+	 	if (dump) {
+			for (int b = 0; b < (int) referenceResultSet.size(); b++)
+				referenceResultSet[b]->csvDump(*dump, ("referenceResultTensor[" + std::to_string(b) + "]").c_str());
+			for (int b = 0; b < (int) exactResultSet.size(); b++)
+				exactResultSet[b]->csvDump(*dump, ("exactResultTensor[" + std::to_string(b) + "]").c_str());
+			delete dump;
+	 	}
+	 	if (option_save && option_trials == 1)
+	 		saveTrial(*simulatedActivationSet, *simulatedFilterSet, *simulatedResultSet);
+
+	 	// cleanup
+		delete simulatedActivationSet;
+		delete simulatedFilterSet;
+		delete simulatedResultSet;
+		delete referenceActivationSet;
+		delete referenceFilterSet;
+		for (int b = 0; b < (int) referenceResultSet.size(); b++)
+			delete referenceResultSet[b];
+		for (int b = 0; b < (int) exactResultSet.size(); b++)
+			delete exactResultSet[b];
+	} timer.stop();
+
+	// print results
+	out.precision(2);
+	out << "conv2D batch trial: " << buffer.str() << ", ";
+	reportErrors(out, result, floatError);
+	out << ", " << timer().c_str() << " sim time, seed " << seed << std::endl; 
+	if (option_counters)
+		out << "HW counters: " << result.counters() << std::endl;
+	if (option_verbose && option_arena)
+		out << "Arena memory: " << arena.peak() << " bytes peak in trial, " << Arena_t::peakReserved() << " bytes peak reserved" << std::endl;
+	return result;
+}
+
+// conv2dTrials: run option_trials independent trials (batched if option_batch > 1) on option_threads host threads.
+// Trial t uses seed option_seed + t (option_seed == 0 picks a random base seed), so any one of them can be replayed alone. 
+// Each trial report is printed as soon as the trial finishes, so with several threads the order varies; aggregate error 
+// statistics, the number of trials that failed the bit for bit check, and the summed counters follow once all trials are done. The csv dump file is only written for a single trial.
+void conv2dTrials(const char* ofile) {
+	Timer timer;
+	std::random_device rd;
+	unsigned baseSeed = option_seed ? (unsigned) option_seed : (rd() & 0x3fffffff) + 1;		// small enough to replay through --seed
+	int K = option_trials;
+	std::vector<trialResult_t> results(K);
+	std::mutex outLock;
+	TileScheduler_t scheduler(option_threads);
+
+	timer.start();
+	scheduler.run(K, [&](int t, int) {
+		std::ostringstream report;
+		unsigned seed = baseSeed + (unsigned) t;
+		if (option_batch > 1)
+			results[t] = conv2dBatchTrial(seed, K == 1 ? ofile : NULL, report);
+		else
+			results[t] = conv2dTrial(seed, K == 1 ? ofile : NULL, report);
+		std::lock_guard<std::mutex> guard(outLock);
+		std::cout << report.str();
+	});
+	timer.stop();
+	if (K == 1)
+		return;
+
+	// aggregate error statistics
+	double sumError = 0.0, sumSquares = 0.0;
+	float maxError = 0.0;
+	unsigned maxSeed = baseSeed;
+	int exact = 0, failed = 0;
+	unsigned failedSeed = baseSeed;
+	hwMMcounters_t counters;
+	for (int t = 0; t < K; t++) {
+		float err = results[t].rmsError;
+		sumError += err;
+		sumSquares += (double) err * err;
+		if (err > maxError) {
+			maxError = err;
+			maxSeed = baseSeed + (unsigned) t;
+		}
+		if (err == 0.0)
+			exact++;
+		if (results[t].mismatches > 0 && failed++ == 0)
+			failedSeed = baseSeed + (unsigned) t;
+		counters += results[t].counters;
+	}
+	double mean = sumError / K;
+	double stddev = pow(std::max(sumSquares / K - mean * mean, 0.0), 0.5);
 	std::cout.precision(2);
-	std::cout << "conv2D trial: " << buffer.str() << ", " << (rmsError * 100.0) << "% rms error, " << timer().c_str() << " sim time" << std::endl; 
+	std::cout << "conv2D trials: " << K << " trials, seeds " << baseSeed << ".." << baseSeed + (unsigned) (K - 1) << ", rms error mean " << (mean * 100.0) << 
+			"%, std dev " << (stddev * 100.0) << "%, max " << (maxError * 100.0) << "% (seed " << maxSeed << "), " << exact << " exact";
+	if (option_reference != CONV_REF_FLOAT) {
+		std::cout << ", " << failed << " with mismatches";
+		if (failed)
+			std::cout << " (first seed " << failedSeed << ")";
+	}
+	std::cout << ", " << timer().c_str() << " total time" << std::endl;
+	if (option_counters)
+		std::cout << "HW counters (all trials): " << counters() << std::endl;
 }
 
 // genActivation: generate an activation tensor using random fixed point data.
 // 8-bit integer numbers are assumed signed in the range -128 .. +127. 
 // No quantization scale factor is assumed (or in effect, == 1.0; that is, if given a real number N, the corresponding 8-bit integer would have value int(1.0 * N)).
-// Limits are assumed in the tensor size generated per command line options.
+// Limits are assumed in the tensor size generated per command line options; with option_groups > 1, the depth is rounded up
+// to a multiple of the groups. The tensor is stored in option_layout.
 
-Tensor_t<int8_t> *genActivation() { 
+Tensor_t<int8_t> *genActivation(std::mt19937& gen) { 
 	// random number generators
-	std::random_device rd; 
-    std::mt19937 gen(rd());
 	std::uniform_int_distribution<> randW(option_minW, option_maxW);
 	std::uniform_int_distribution<> randH(option_minH, option_maxH);
 	std::uniform_int_distribution<> randD(option_minD, option_maxD);
@@ -110,7 +460,9 @@ Tensor_t<int8_t> *genActivation() {
 	W = randW(gen);
 	H = randH(gen);
 	D = randD(gen);
-	act = new Tensor_t<int8_t>(W, H, D); 
+	if (option_groups > 1)
+		D = (D + option_groups - 1) / option_groups * option_groups;
+	act = new Tensor_t<int8_t>(W, H, D, (tensorLayout_t) option_layout);
 	for (int i = 0; i < W; i++)
 		for (int j = 0; j < H; j++)
 			for (int k = 0; k < D; k++)
@@ -118,14 +470,41 @@ Tensor_t<int8_t> *genActivation() {
 	return act;
 }
 
+// genActivations: generate a batch of B activation tensors of one random shape, as for genActivation().
+
+TensorArray_t<int8_t> *genActivations(int B, std::mt19937& gen) { 
+	// random number generators
+	std::uniform_int_distribution<> randW(option_minW, option_maxW);
+	std::uniform_int_distribution<> randH(option_minH, option_maxH);
+	std::uniform_int_distribution<> randD(option_minD, option_maxD);
+	std::uniform_int_distribution<> randData(-option_maxInt, option_maxInt);
+
+	// local data
+	TensorArray_t<int8_t>* acts;
+	int W, H, D;
+
+	W = randW(gen);
+	H = randH(gen);
+	D = randD(gen);
+	if (option_groups > 1)
+		D = (D + option_groups - 1) / option_groups * option_groups;
+	acts = new TensorArray_t<int8_t>(B, W, H, D, (tensorLayout_t) option_layout);
+	for (int b = 0; b < B; b++)
+		for (int i = 0; i < W; i++)
+			for (int j = 0; j < H; j++)
+				for (int k = 0; k < D; k++)
+					(*acts)[b](i,j,k) = randData(gen);
+	return acts;
+}
+
 // genFilters: generate a filter tensor set using random fixed point data.
 // Similar to genActivation() in that 8-bit integer numbers are assumed signed in the range -128 .. +127, and similarly no quantization scale factor is employed. 
-// Limits are assumed in the tensor array size generated per command line options.
+// Limits are assumed in the tensor array size generated per command line options. For a grouped (or depthwise) convolution 
+// per option_groups, the filters have the depth of one group and the channel count is rounded up to a multiple of the groups.
+// With option_sparsity, the filters are pruned per pruneFilters(). The filters are stored in the layout of the activations.
 
-TensorArray_t<int8_t> *genFilters(const Tensor_t<int8_t>* act) { 
+TensorArray_t<int8_t> *genFilters(const Tensor_t<int8_t>* act, std::mt19937& gen) { 
 	// random number generators
-	std::random_device rd; 
-    std::mt19937 gen(rd());
 	std::uniform_int_distribution<> randKW(option_minKW, option_maxKW);
 	std::uniform_int_distribution<> randKH(option_minKH, option_maxKH);
 	std::uniform_int_distribution<> randC(option_minC, option_maxC);
@@ -134,29 +513,67 @@ TensorArray_t<int8_t> *genFilters(const Tensor_t<int8_t>* act) {
 	// local data
 	TensorArray_t<int8_t>* filterArray;
 	Tensor_t<int8_t>* filt;
-	int C, KW, KH, D;
+	int C, KW, KH, D, G;
 
-	// generate a random filter size, but constrain to be no wider/taller than activation
-	KW = randKW(gen); if (act->width() < KW) KW = act->width();
-	KH = randKH(gen); if (act->height() < KH) KH = act->height();
+	// generate a random filter size, but constrain to be no wider/taller than activation (once dilated)
+	KW = randKW(gen); if ((act->width() - 1) / option_dilation + 1 < KW) KW = (act->width() - 1) / option_dilation + 1;
+	KH = randKH(gen); if ((act->height() - 1) / option_dilation + 1 < KH) KH = (act->height() - 1) / option_dilation + 1;
 
-	// constrain depth to match activation; generate random channel count
-	D = act->depth();
+	// constrain depth to match activation (one group of it); generate random channel count
+	G = trialGroups(act->depth());
+	D = act->depth() / G;
 	C = randC(gen);
+	C = (C + G - 1) / G * G;
 
 	// generate the filter set and initialize data
-	filterArray = new TensorArray_t<int8_t>(C, KW, KH, D); 
+	filterArray = new TensorArray_t<int8_t>(C, KW, KH, D, act->layout());
 	for (int c = 0; c < C; c++)
 		for (int i = 0; i < KW; i++)
 			for (int j = 0; j < KH; j++)
 				for (int k = 0; k < D; k++)
 					(*filterArray)[c](i,j,k) = randData(gen);
+	if (option_sparsity > 0)
+		pruneFilters(*filterArray, option_sparsity, gen);
 	return filterArray;
 }	
 
+// pruneFilters: zero about "percent" % of the weights of a filter set the way HW aware block pruning does: the C x length
+// matrix of serialized filters is cut in P x P blocks (P filters by P serialized elements, hwMM.P), and each block is 
+// zeroed with probability percent / 100. For a dense convolution these blocks are the multiplier tiles.
+
+void pruneFilters(TensorArray_t<int8_t>& filtSet, int percent, std::mt19937& gen) {
+	std::bernoulli_distribution prune(percent / 100.0);
+	int C = filtSet.count(), L = filtSet.length(), P = hwMM.P;
+
+	for (int c0 = 0; c0 < C; c0 += P)
+		for (int l0 = 0; l0 < L; l0 += P)
+			if (prune(gen))
+				for (int c = c0; c < std::min(c0 + P, C); c++)
+					memset(filtSet.buffer() + c * filtSet.stride() + l0, 0, std::min(P, L - l0));
+}
+
+// genEpilogue: generate the writeback epilogue for a filter set per command line options: the accumulator model, with 
+// multipliers calibrated for the filter set; with option_bias, random per channel biases of up to one standard deviation
+// of the channel sums; and the activation function.
+
+hwMMepilogue_t genEpilogue(const TensorArray_t<int8_t>& filtSet, std::mt19937& gen) {
+	hwMMepilogue_t epi = hwMMepilogue_t::calibrate(option_accum, filtSet, option_maxInt);
+
+	if (option_bias)
+		for (int c = 0; c < filtSet.count(); c++) {
+			int sigma = (int) lround(127.0 / (4.0 * epi.scaleD[c] * epi.unitD[c]));		// inverse of the calibration
+			std::uniform_int_distribution<> randBias(-sigma, sigma);
+			epi.setBias(c, randBias(gen));
+		}
+	epi.setActivation(option_activation, option_clampMin, option_clampMax);
+	return epi;
+}
+
 // simulatedConv2D: simulate 2D convolution on 8-bit ints using a simulated HW MM engine.
-// Since we assume no padding and stride = 1, the result tensor is inset by 1 on all for sides 
-// of the face of the activation sensor and has depth = channel count in the filter set. 
+// With the default parameters (no padding and stride = 1), the result tensor is inset by 1 on all for sides 
+// of the face of the activation sensor and has depth = channel count in the filter set. Stride, dilation and SAME
+// padding ("params") change the output face per conv2DGeometry_t; padding is applied virtually while gathering
+// activation slices (taps outside the activation read 0), so no padded copy of the activation is ever made.
 //
 // To do this, we successively extract filter-size subtensors (filter tensors from the "filtSet" array)
 // from the activation tensor ("act"). Each such subtensor is then serialized (meaning converted from tensor
@@ -177,109 +594,654 @@ TensorArray_t<int8_t> *genFilters(const Tensor_t<int8_t>* act) {
 // The "fij" represent filters @ i/j values; "vi" represents an input vector slice from 1..Q; "res" is the output vector slice.
 // This form of multiplication can suffer from numeric overflows on the intermediate sums and in the latter accumulation (and the 
 // errors can be pretty extreme).
+//
+// By default (option_implicit) the activation subtensors are never materialized: each P-wide slice of "hwMMvectors" is gathered
+// directly from the activation tensor by index arithmetic (implicit GEMM). With "--implicit 0", the original path is used which
+// serializes a full subtensor window (a TensorView_t, so no subtensor copy) per output position first. Both produce identical results.
+//
+// The filters are consumed as a PackedFilters_t: each P x P operand tile is laid out once, zero-padded, in multiplier order.
+// Callers that run the same weights repeatedly can pass a packed set in "packedFiltSet" so the packing cost is paid once.
+//
+// A grouped convolution (params.groups > 1, e.g. depthwise) runs channel tile by channel tile of the packed set: each
+// gathers its vectors from the activation channels of the groups it holds. With option_groupPack, a tile holds as many
+// small groups as fit in P columns side by side, block diagonally, so a depthwise layer needs a P-th of the invocations
+// it takes with one group per tile. Counted useful MACs exclude the zeros off the diagonal blocks.
+//
+// The multiplier itself is one of the kernels in hwmm.cpp (scalar, AVX2 or AVX-512 VNNI), picked at runtime per option_kernel
+// and the CPU; all of them reproduce the 8-bit wraparound accumulation bit for bit.
+//
+// With option_threads > 1, (channel tile, surface tile) units run on several host threads, each with its own copy of
+// the multiplier state (hwMMstate_t).
+//
+// With hwMM.engines > 0, the units are split in contiguous blocks over that many modeled multiplier engines instead, each
+// run in order by one host thread with its own state, and the layer's cycles on the engines and their shared load port
+// are modeled from the steps each engine took (see modelEngines()). The result is the same as with a single multiplier.
+//
+// With option_pipeline, every unit runs in two stages, the way HW overlaps its loads with compute: a producer thread per 
+// host thread (or engine) gathers all input vectors of the next unit into one of two stage buffers while the unit before
+// multiplies from the other one (see TileScheduler_t). Vectors are then always gathered implicitly. Modeled engines
+// double buffer their operands, so each loads the next step while computing the current one; without option_pipeline, 
+// loads and compute alternate. The result and the counts are the same either way.
+//
+// The dataflow (option_dataflow, see convDataflow_t) decides which operand stays in the multiplier: output stationary 
+// (the default) keeps the accumulators of one (channel tile, surface tile) and reloads tiles and vectors every step; weight
+// stationary loads each filter tile once per surface chunk, input stationary gathers each vector slice once per channel 
+// chunk. Both keep the accumulators of a whole chunk, and always gather implicitly. The result is the same for every
+// dataflow; the data movement counters and the host time are not. CONV_FLOW_AUTO takes the dataflow from the tuning
+// cache, and with option_tune finds it first (see selectDataflow()).
+//
+// The activations and filters share a layout (tensorLayout_t), which is the layout of the result too. With channel last 
+// tensors, the serialized window of an output position is ordered (row, column, channel), each window row spanning the
+// full depth is one contiguous run gathered with a single copy, and each output position's channels are written back
+// with one copy. Groups are not packed then (see PackedFilters_t), and vectors are always gathered implicitly.
+//
+// If "counters" is given, it receives the layer's utilization and data movement counts (see hwMMcounters_t).
+//
+// "epilogue" selects the accumulator model and the writeback into "res" (see hwMMepilogue_t); NULL means 8-bit wraparound. 
+// Accumulators are simulated as int32 exact sums, except that saturating 8-bit accumulators are clamped after every step.
+// Bias, requantization and activation are applied to each accumulator tile as it is written back, in one vectorized pass.
+//
+// With a "band", only output rows [band->j0, band->j1) are computed (the result tensor has just those rows) and "act" holds
+// only activation rows [band->base, band->base + act->height()) of an input band->H rows high. Padding still follows the
+// full input, and every row the band reads must be present. Fused layer execution (see convNetwork_t) works this way.
+
+// per-thread simulated HW multiplier state: row n of "hwMMvectors" is input vector n; "hwMMres" holds the accumulators
+// of "blocks" N-vector blocks (one for output stationary dataflows), row n of a block for vector n; "hwMMpartial" holds 
+// the dot products of one step for saturating accumulators; "hwMMout" the 8-bit outputs of the writeback epilogue;
+// "actVecArray" holds serialized activation subtensors when not gathering slices implicitly; 
+// "arena" holds the temporaries of one unit (reset after each unit); "trace" the steps of an engine (with hwMM.engines);
+// with option_pipeline, "stage" holds the vectors of a unit gathered ahead by the producer stage, in two buffers, and
+// "producerCounters" takes the counts of the producer stage, which are not part of the layer's
+struct hwMMstate_t {
+	Matrix_t<int8_t> hwMMvectors;
+	Matrix_t<int32_t> hwMMres;
+	Matrix_t<int32_t> hwMMpartial;
+	Matrix_t<int8_t> hwMMout;
+	VectorArray_t<int8_t> actVecArray;
+	Arena_t arena;
+	hwMMcounters_t counters;
+	EngineTrace_t trace;
+	std::vector<int8_t> stage[2];
+	hwMMcounters_t producerCounters;
+
+	hwMMstate_t(int N, int P, int IL, int blocks = 1) : hwMMvectors(P, N), hwMMres(P, blocks * N), hwMMpartial(P, N), hwMMout(P, N), 
+			actVecArray(option_implicit ? 1 : N, option_implicit ? 1 : IL) {}
+};
 
-Tensor_t<int8_t> *simulatedConv2D(Tensor_t<int8_t> *act, TensorArray_t<int8_t> *filtSet) { 
-	// model the HW matrices and vector arrays
-	VectorArray_t<int8_t> hwMMvectors(hwMM.N, hwMM.P); 
-	VectorArray_t<int8_t> hwMMmatrix(hwMM.P, hwMM.P);
-	Matrix_t<int8_t> hwMMres(hwMM.N, hwMM.P);
+// one pass over a simulation unit: the whole unit, or with option_pipeline its producer stage (which only gathers the
+// vectors into stage buffer "buffer") or its consumer stage (which takes them from there, in the same order)
+struct unitPass_t {
+	bool producing;
+	int buffer;						// stage buffer; -1 if not pipelined
+	size_t cursor;					// consumer: staged bytes used so far
+	const int8_t *vectors;			// the input vectors of the current step
 
-	// serialize versions of the filters
-	VectorArray_t<int8_t> serializedFiltSet(filtSet->count(), filtSet->length());
-	for (int c = 0; c < filtSet->count(); c++)
-		serializeTensor2Vector(serializedFiltSet[c], (*filtSet)[c]);
+	unitPass_t(bool _producing, int _buffer) : producing(_producing), buffer(_buffer), cursor(0), vectors(NULL) {}
+};
+
+// simulateDataflow: the body of simulatedConv2D() for one dataflow "flow" (convDataflow_t other than CONV_FLOW_AUTO)
+static Tensor_t<int8_t> *simulateDataflow(Tensor_t<int8_t> *act, TensorArray_t<int8_t> *filtSet, const conv2DParams_t& params, const PackedFilters_t<int8_t> *packed, 
+		hwMMcounters_t *counters, const hwMMepilogue_t& epi, const convBand_t *band, int flow) { 
+	hwMMkernel_t hwMMmultiply = hwMMselectKernel(option_kernel, option_specialize ? hwMM.P : 0);
+	bool saturate = epi.accum == HWMM_ACC_SAT8;
+	TileScheduler_t scheduler(option_threads);
 
 	// compute output tensor dimensions
-	int OW = act->width() - filtSet->width() + 1;
-	int OH = act->height() - filtSet->height() + 1;
+	conv2DGeometry_t geom(act->width(), band ? band->H : act->height(), filtSet->width(), filtSet->height(), params);
+	int OW = geom.OW;
+	int OH = band ? band->j1 - band->j0 : geom.OH;		// output rows computed
+	int J0 = band ? band->j0 : 0;						// first output row computed
+	int base = band ? band->base : 0;					// activation row held in row 0 of "act"
 	int OS = OW * OH;									// output surface count
 	int OD = filtSet->count();
-	Tensor_t<int8_t>* res = new Tensor_t<int8_t>(OW, OH, OD);
+	Tensor_t<int8_t>* res = new Tensor_t<int8_t>(OW, OH, OD, act->layout());
 
-	// get input dimensions
-	int IL = filtSet->length();
+	// get input dimensions; a channel tile's serialized window is up to IL long (longer than a filter if it holds several groups)
+	int IL = packed->groupsPerTile() * filtSet->length();
 
 	// Loop structure:
-	// For each C (channel); grab up to next P serialized filters for channel
+	// For each C (channel); grab up to next P serialized filters for channel (a channel tile of the packed set)
 	//		For each S (tensor) in the surface (2D) of the activation tensor; grab up to next N serialized activation subtensors
 	//			For each P-sized slice of both the P serialized filters and N serialized activation subtensors, DOT them to accumulate NxP output elements
-	for (int c = 0; c < OD; c += hwMM.P) {
-		VectorArray_t<int8_t> actVecArray(hwMM.N, filtSet->length());
+	// Each (channel tile, surface tile) pair writes a disjoint block of "res". The output stationary dataflows flatten the
+	// outer two loops (in either order) into units handed out by the work-stealing scheduler. Weight stationary units are
+	// (channel tile, chunk of surface tiles) and move the slice loop outside the surface tiles; input stationary units are 
+	// (surface tile, chunk of channel tiles) and move it outside the channel tiles. Chunks only split the stationary loop 
+	// when there are fewer units than threads (or engines) otherwise; each keeps the accumulators of all its blocks until 
+	// the last slice. The output is the same for any dataflow, thread count and engine count.
+	int slots = engineSlots(scheduler, hwMM.engines);
+	int surfaceTiles = (OS + hwMM.N - 1) / hwMM.N;
+	int channelTiles = packed->channelTiles();
+	int units = channelTiles * surfaceTiles, chunks = 1, chunkTiles = 1;
+	if (flow == CONV_FLOW_WS) {
+		chunks = std::min((slots + channelTiles - 1) / channelTiles, surfaceTiles);
+		chunkTiles = (surfaceTiles + chunks - 1) / chunks;
+		units = channelTiles * chunks;
+	} else if (flow == CONV_FLOW_IS) {
+		chunks = std::min((slots + surfaceTiles - 1) / surfaceTiles, channelTiles);
+		chunkTiles = (channelTiles + chunks - 1) / chunks;
+		units = surfaceTiles * chunks;
+	}
+
+	// model the HW matrices and vector arrays, one set per host thread (or engine)
+	std::vector<hwMMstate_t *> state(slots);
+	for (size_t t = 0; t < state.size(); t++)
+		state[t] = new hwMMstate_t(hwMM.N, hwMM.P, IL, chunkTiles);
+
+	// gather slice [ijk, ijk + sliceLen) of the serialized windows over activation channels [k, k + KD) at output positions 
+	// s .. s + rows - 1 straight from the activation tensor into "hwMMvectors", or into the stage buffer when producing; 
+	// the consumer stage takes the next staged vectors instead
+	auto gather = [&](hwMMstate_t& st, unitPass_t& pass, int s, int rows, int k, int KD, int ijk, int sliceLen) {
+		int8_t *dst = st.hwMMvectors.pointer();
+		if (pass.buffer >= 0 && !pass.producing) {
+			pass.vectors = st.stage[pass.buffer].data() + pass.cursor;
+			pass.cursor += rows * hwMM.P;
+			st.counters.loadVectors(hwMM.P, rows);
+			return;
+		}
+		if (pass.producing) {
+			std::vector<int8_t>& stage = st.stage[pass.buffer];
+			stage.resize(stage.size() + rows * hwMM.P);
+			dst = stage.data() + stage.size() - rows * hwMM.P;
+		}
+		for (int ss = 0; ss < rows; ss++) {
+			int ii = (s+ss) % OW; int jj = J0 + (s+ss) / OW; 
+			gatherSubtensorSlice(dst + ss * hwMM.P, hwMM.P, *act, geom.originW(ii), geom.originH(jj) - base, k, filtSet->width(), filtSet->height(), KD, 
+					ijk, sliceLen, params.dilationW, params.dilationH);
+		}
+		pass.vectors = dst;
+		if (!pass.producing)
+			st.counters.loadVectors(hwMM.P, rows);
+	};
 
-		// grab up to next Q serialized filters for channel
-		int chanCount = OD - c; if (chanCount > hwMM.P) chanCount = hwMM.P;
+	// one multiplier step of "rows" vectors against "hwMMmatrix" into the accumulators "acc"; rows past "rows" are idle 
+	// (their results are never stored) so they are not computed. The producer stage does not multiply.
+	auto multiply = [&](hwMMstate_t& st, const unitPass_t& pass, int32_t *acc, const int8_t *hwMMmatrix, int rows) {
+		if (pass.producing)
+			return;
+		if (saturate) {
+			memset(st.hwMMpartial.pointer(), 0, rows * hwMM.P * sizeof(int32_t));
+			hwMMmultiply(st.hwMMpartial.pointer(), pass.vectors, hwMMmatrix, rows, hwMM.P);
+			hwMMsaturate(acc, st.hwMMpartial.pointer(), rows * hwMM.P);
+		} else
+			hwMMmultiply(acc, pass.vectors, hwMMmatrix, rows, hwMM.P);
+	};
+
+	// run the completed accumulators "acc" of channel tile ct at output positions s .. s + rows - 1 through the epilogue and 
+	// store them in the result tensor; the positions are consecutive in each channel plane, or with a channel last result,
+	// each position's channels are one contiguous run
+	auto writeback = [&](hwMMstate_t& st, const unitPass_t& pass, const int32_t *acc, int ct, int s, int rows) {
+		if (pass.producing)
+			return;
+		int c = packed->tileChannel(ct), chanCount = packed->tileChannels(ct);
+		epi.store(st.hwMMout.pointer(), acc, rows, hwMM.P, c, chanCount);
+		int8_t *dst = &(*res)(0, 0, 0) + s * res->columnStride() + c * res->channelStride();
+		if (res->layout() == TENSOR_LAYOUT_HWC)
+			for (int ss = 0; ss < rows; ss++)
+				memcpy(dst + ss * OD, st.hwMMout.pointer(ss), chanCount);
+		else
+			for (int cc = 0; cc < chanCount; cc++)
+				for (int ss = 0; ss < rows; ss++)
+					dst[cc * OS + ss] = st.hwMMout(cc, ss);
+		st.counters.writeback(rows * chanCount);
+	};
+
+	// count a multiplier step of "rows" vectors, and trace it for the engine model
+	auto invoke = [&](hwMMstate_t& st, const unitPass_t& pass, int rows, int ct, int sliceLen, int work) {
+		if (pass.producing)
+			return;
+		st.counters.invoke(hwMM.N, hwMM.P, rows, packed->tileChannels(ct), sliceLen, work);
+		if (hwMM.engines)
+			st.trace.step(st.counters, engineStepCycles(hwMM.N));
+	};
+
+	// simulate one unit, or one stage of it; channel last activations have no views to serialize, so are always gathered
+	bool implicit = option_implicit || option_pipeline || act->layout() != TENSOR_LAYOUT_CHW;
+	auto runUnit = [&](int unit, int slot, unitPass_t& pass) {
+		hwMMstate_t& st = *state[slot];
+		Matrix_t<int32_t>& hwMMres = st.hwMMres;
+		VectorArray_t<int8_t>& actVecArray = st.actVecArray;
+		hwMMcounters_t& count = pass.producing ? st.producerCounters : st.counters;
+		const int8_t *hwMMmatrix;										// the operand matrix is a P x P tile streamed from the packed filter set
+		ArenaScope_t scope(option_arena && !pass.producing ? &st.arena : NULL);
+
+		// init HW MM result matrix (the accumulators), or the stage buffer
+		if (pass.producing)
+			st.stage[pass.buffer].clear();
+		else
+			hwMMres.setMatrix2constant(0);
+
+		if (flow == CONV_FLOW_WS) {
+			// weight stationary: each slice of the channel tile's filters is loaded once for all surface tiles of the chunk
+			int ct = unit / chunks;
+			int t0 = (unit % chunks) * chunkTiles, t1 = std::min(t0 + chunkTiles, surfaceTiles);
+			int k = packed->tileInputChannel(ct), KD = packed->tileInputDepth(ct);
+			int VL = packed->tileLength(ct);
+			for (int b = packed->firstBlock(ct); b < packed->endBlock(ct); b++) {
+				int ijk = packed->blockSlice(b) * hwMM.P;
+				int sliceLen = VL - ijk; if (sliceLen > hwMM.P) sliceLen = hwMM.P;
+				int work = packed->tileWork(ct, ijk / hwMM.P);
+				hwMMmatrix = packed->block(b);
+				count.loadMatrix(hwMM.P);
+				for (int t = t0; t < t1; t++) {
+					int s = t * hwMM.N;
+					int osLen = OS - s; if (osLen > hwMM.N) osLen = hwMM.N;
+					gather(st, pass, s, osLen, k, KD, ijk, sliceLen);
+					multiply(st, pass, hwMMres.pointer((t - t0) * hwMM.N), hwMMmatrix, osLen);
+					invoke(st, pass, osLen, ct, sliceLen, work);
+				}
+			}
+			count.skip((packed->tileSlices(ct) - (packed->endBlock(ct) - packed->firstBlock(ct))) * (t1 - t0));
+			for (int t = t0; t < t1; t++) {
+				int osLen = OS - t * hwMM.N; if (osLen > hwMM.N) osLen = hwMM.N;
+				writeback(st, pass, hwMMres.pointer((t - t0) * hwMM.N), ct, t * hwMM.N, osLen);
+			}
+		} else if (flow == CONV_FLOW_IS) {
+			// input stationary: each slice of the surface tile's vectors is gathered once for all channel tiles of the chunk
+			// that read the same activation channels (all of them unless the convolution is grouped) and have a nonzero tile
+			int s = (unit / chunks) * hwMM.N;
+			int c0 = (unit % chunks) * chunkTiles, c1 = std::min(c0 + chunkTiles, channelTiles);
+			int osLen = OS - s; if (osLen > hwMM.N) osLen = hwMM.N;
+			int maxVL = 0;
+			for (int ct = c0; ct < c1; ct++)
+				maxVL = std::max(maxVL, packed->tileLength(ct));
+			for (int ijk = 0; ijk < maxVL; ijk += hwMM.P) {
+				int gathered = -1;									// first activation channel of the vectors held
+				for (int ct = c0; ct < c1; ct++) {
+					int k = packed->tileInputChannel(ct), KD = packed->tileInputDepth(ct);
+					int VL = packed->tileLength(ct);
+					if (ijk >= VL)
+						continue;
+					int sliceLen = VL - ijk; if (sliceLen > hwMM.P) sliceLen = hwMM.P;
+					hwMMmatrix = packed->tile(ct, ijk / hwMM.P);
+					if (hwMMmatrix == NULL) {
+						count.skip(1);
+						continue;
+					}
+					if (k != gathered) {
+						gather(st, pass, s, osLen, k, KD, ijk, sliceLen);
+						gathered = k;
+					}
+					count.loadMatrix(hwMM.P);
+					multiply(st, pass, hwMMres.pointer((ct - c0) * hwMM.N), hwMMmatrix, osLen);
+					invoke(st, pass, osLen, ct, sliceLen, packed->tileWork(ct, ijk / hwMM.P));
+				}
+			}
+			for (int ct = c0; ct < c1; ct++)
+				writeback(st, pass, hwMMres.pointer((ct - c0) * hwMM.N), ct, s, osLen);
+		} else {
+			// output stationary: the accumulators of one (channel tile, surface tile) stay for all slices
+			int ct = flow == CONV_FLOW_OS_SURFACE ? unit % channelTiles : unit / surfaceTiles;
+			int s = (flow == CONV_FLOW_OS_SURFACE ? unit / channelTiles : unit % surfaceTiles) * hwMM.N;
+
+			// grab up to next Q serialized filters for channel, and the activation channels [k, k + KD) they read
+			int k = packed->tileInputChannel(ct), KD = packed->tileInputDepth(ct);
+			int VL = packed->tileLength(ct);
 
-		// For each S (tensor) in the surface (2D) of the output tensor
-		for (int s = 0; s < OS; s += hwMM.N) {
 			// grab up to next N serialized activation subtensors. 
 			// extract subtensors from the activation tensor and serialize them into up to N vectors; unused vectors remain 0
 			int osLen = OS - s; if (osLen > hwMM.N) osLen = hwMM.N;
-			for (int ss = 0; ss < osLen; ss++) {
-				int ii = (s+ss) % OW; int jj = (s+ss) / OW; 
-				serializeTensor2Vector(actVecArray[ss], act->extractSubtensor(ii, jj, 0, filtSet->width(), filtSet->height(), filtSet->depth()));
+			if (!implicit) {
+				for (int ss = 0; ss < osLen; ss++) {
+					int ii = (s+ss) % OW; int jj = J0 + (s+ss) / OW; 
+					if (params.isDefault())
+						serializeTensor2Vector(actVecArray[ss], act->view(ii, jj - base, 0, filtSet->width(), filtSet->height(), filtSet->depth()));
+					else
+						gatherSubtensorSlice(actVecArray[ss].pointer(), IL, *act, geom.originW(ii), geom.originH(jj) - base, k, filtSet->width(), filtSet->height(), KD, 
+								0, VL, params.dilationW, params.dilationH);
+				}
 			}
 
-			// init HW MM result matrix (the accumulators)
-			for (int n = 0; n < hwMM.N; n++)
-				hwMMres.setMatrix2constant(0);
-
-			// For each P-sized slice of both the P serialized filters and N serialized activation subtensors
-			for (int ijk = 0; ijk < IL; ijk += hwMM.P) {
+			// For each P-sized slice of both the P serialized filters and N serialized activation subtensors with a nonzero filter tile
+			for (int b = packed->firstBlock(ct); b < packed->endBlock(ct); b++) {
 				// compute slice length
-				int sliceLen = IL - ijk; if (sliceLen > hwMM.P) sliceLen = hwMM.P;
+				int ijk = packed->blockSlice(b) * hwMM.P;
+				int sliceLen = VL - ijk; if (sliceLen > hwMM.P) sliceLen = hwMM.P;
 
-				// extract up to N activation surface slices
-				for (int ss = 0; ss < osLen; ss++) {
-					hwMMvectors[ss].setVec2constant(0);
-					hwMMvectors[ss].extractVecSlice(actVecArray[ss], ijk, sliceLen);
+				// extract up to N activation surface slices; in implicit mode, the slice is gathered straight from the activation tensor
+				if (implicit)
+					gather(st, pass, s, osLen, k, KD, ijk, sliceLen);
+				else {
+					for (int ss = 0; ss < osLen; ss++) {
+						memset(st.hwMMvectors.pointer(ss), 0, hwMM.P);
+						memcpy(st.hwMMvectors.pointer(ss), actVecArray[ss].pointer(ijk), sliceLen);
+					}
+					pass.vectors = st.hwMMvectors.pointer();
+					count.loadVectors(hwMM.P, osLen);
 				}
 
-				// extract up to P filter vector slices
-				for (int cc = 0; cc < chanCount; cc++) {
-					hwMMmatrix[cc].setVec2constant(0);
-					hwMMmatrix[cc].extractVecSlice(serializedFiltSet[c+cc], ijk, sliceLen);
-				}
+				// stream the P x P tile holding up to P filter vector slices; unused rows and columns are already 0
+				hwMMmatrix = packed->block(b);
+				count.loadMatrix(hwMM.P);
 
 				// For each P-sized slice of both the P serialized filters and N serialized activation subtensors, DOT them to accumulate NxP output elements
-				// This simulates the HW multiplier
-				for (int n = 0; n < hwMM.N; n++)
-					for (int p = 0; p < hwMM.P; p++)
-						hwMMres(n, p) += hwMMvectors[n] * hwMMmatrix[p]; 
+				multiply(st, pass, hwMMres.pointer(), hwMMmatrix, osLen);
+				invoke(st, pass, osLen, ct, sliceLen, packed->tileWork(ct, ijk / hwMM.P));
 			}
+			count.skip(packed->tileSlices(ct) - (packed->endBlock(ct) - packed->firstBlock(ct)));
+
+			// run the completed accumulators through the epilogue and store them in the result tensor
+			writeback(st, pass, hwMMres.pointer(), ct, s, osLen);
+		}
+	};
+	if (option_pipeline)
+		runOnEngines(scheduler, hwMM.engines, units, [&](int unit, int slot, int buffer) {
+			unitPass_t pass(true, buffer);
+			runUnit(unit, slot, pass);
+		}, [&](int unit, int slot, int buffer) {
+			unitPass_t pass(false, buffer);
+			runUnit(unit, slot, pass);
+		});
+	else
+		runOnEngines(scheduler, hwMM.engines, units, [&](int unit, int slot) {
+			unitPass_t pass(false, -1);
+			runUnit(unit, slot, pass);
+		});
+
+	// cleanup; sum up the per-thread counters, and model the engines
+	if (counters) {
+		std::vector<const EngineTrace_t *> traces;
+		counters->clear();
+		for (size_t t = 0; t < state.size(); t++) {
+			*counters += state[t]->counters;
+			traces.push_back(&state[t]->trace);
+		}
+		if (hwMM.engines)
+			modelEngines(traces, hwMM.loadBytes, option_pipeline ? 2 : 1, *counters);
+	}
+	for (size_t t = 0; t < state.size(); t++)
+		delete state[t];
+	return res; 
+}
+
+// the tuning cache (option_tuneCache), read on first use
+static TuningCache_t& tuningCache() {
+	static TuningCache_t cache(option_tuneCache);
+	return cache;
+}
+
+// selectDataflow: the dataflow of a simulatedConv2D() call with option_dataflow == CONV_FLOW_AUTO. The tuning cache is
+// keyed by the computed output face, input depth, filters, parameters, multiplier size, host threads, engines, layout,
+// the kernel that runs (and whether it is specialized), pipelining, the groups per tile, the percentage of filter tiles
+// stored (sparsity) and the metric. On a miss with option_tune, every dataflow is run (option_warmup untimed and
+// tuneRepeats timed runs; the best time counts), and the one with the least host time or modeled bytes loaded (per
+// option_tuneMetric) is recorded. Without a cached choice, the dataflow is CONV_FLOW_OS_CHANNEL.
+static const int tuneRepeats = 3;
+
+static int selectDataflow(Tensor_t<int8_t> *act, TensorArray_t<int8_t> *filtSet, const conv2DParams_t& params, const PackedFilters_t<int8_t> *packed, 
+		const hwMMepilogue_t& epi, const convBand_t *band) {
+	conv2DGeometry_t geom(act->width(), band ? band->H : act->height(), filtSet->width(), filtSet->height(), params);
+	std::ostringstream key, scores;
+	int flow = CONV_FLOW_OS_CHANNEL;
+
+	key << geom.OW << "x" << (band ? band->j1 - band->j0 : geom.OH) << "x" << act->depth() << " by " << filtSet->count() << " of " << filtSet->width() << "x" << 
+			filtSet->height() << "x" << filtSet->depth() << ", " << params() << ", N " << hwMM.N << ", P " << hwMM.P << ", " << option_threads << " threads, ";
+	if (hwMM.engines)
+		key << hwMM.engines << " engines, ";
+	if (act->layout() == TENSOR_LAYOUT_HWC)
+		key << "hwc, ";
+	key << hwMMkernelName(hwMMresolveKernel(option_kernel)) << (option_specialize && hwMMspecialized(hwMM.P) ? " specialized" : "") << " kernel, ";
+	if (option_pipeline)
+		key << "pipelined, ";
+	if (packed->groupsPerTile() > 1)
+		key << packed->groupsPerTile() << " groups per tile, ";
+	if (packed->blocks() < packed->windowBlocks())
+		key << (100 * packed->blocks() + packed->windowBlocks() / 2) / packed->windowBlocks() << "% tiles, ";
+	key << convTuneMetricName(option_tuneMetric);
+	if (tuningCache().lookup(key.str(), flow) || !option_tune)
+		return flow;
+
+	// one shape is tuned at a time, so parallel trials don't tune the same shape twice or skew each other's timing
+	static std::mutex tuneLock;
+	std::lock_guard<std::mutex> guard(tuneLock);
+	if (tuningCache().lookup(key.str(), flow))
+		return flow;
+	double best = 0.0;
+	scores.precision(4);
+	for (int f = CONV_FLOW_AUTO + 1; f <= convDataflows; f++) {
+		double score = 0.0;
+		for (int r = -option_warmup; r < tuneRepeats; r++) {
+			hwMMcounters_t count;
+			Timer timer;
+			timer.start();
+			delete simulateDataflow(act, filtSet, params, packed, &count, epi, band, f);
+			timer.stop();
+			if (r < 0)
+				continue;
+			double value = option_tuneMetric == CONV_TUNE_BYTES ? (double) (count.vectorBytes + count.matrixBytes) : *timer;
+			if (r == 0 || value < score)
+				score = value;
+		}
+		scores << (f > CONV_FLOW_AUTO + 1 ? ", " : "") << convDataflowName(f) << " " << score;
+		if (f == CONV_FLOW_AUTO + 1 || score < best) {
+			best = score;
+			flow = f;
+		}
+	}
+	tuningCache().record(key.str(), flow, scores.str());
+	if (option_verbose)
+		std::cerr << "tuned " << key.str() << ": " << convDataflowName(flow) << " (" << scores.str() << ")" << std::endl;
+	return flow;
+}
+
+Tensor_t<int8_t> *simulatedConv2D(Tensor_t<int8_t> *act, TensorArray_t<int8_t> *filtSet, const conv2DParams_t& params, const PackedFilters_t<int8_t> *packedFiltSet, 
+		hwMMcounters_t *counters, const hwMMepilogue_t *epilogue, const convBand_t *band) { 
+	hwMMepilogue_t wrap(HWMM_ACC_WRAP8, filtSet->count());
+	const hwMMepilogue_t& epi = epilogue ? *epilogue : wrap;
+
+	// pack the filters into multiplier tiles unless the caller supplied a packed set for this layer
+	const PackedFilters_t<int8_t> *packed = packedFiltSet;
+	if (packed == NULL)
+		packed = new PackedFilters_t<int8_t>(*filtSet, hwMM.P, params.groups, option_groupPack, option_sparse);
+	assert(packed->matches(*filtSet, hwMM.P, params.groups) && act->depth() == filtSet->depth() * params.groups && act->layout() == filtSet->layout());
+
+	// pick the dataflow, and simulate
+	int flow = option_dataflow == CONV_FLOW_AUTO ? selectDataflow(act, filtSet, params, packed, epi, band) : option_dataflow;
+	Tensor_t<int8_t> *res = simulateDataflow(act, filtSet, params, packed, counters, epi, band, flow);
+	if (packed != packedFiltSet)
+		delete packed;
+	return res; 
+}
+
+// simulatedConv2DDataflow: the dataflow simulatedConv2D() runs with these arguments: option_dataflow, or with CONV_FLOW_AUTO
+// the one selectDataflow() picks (tuning it first on a cache miss with option_tune)
+int simulatedConv2DDataflow(Tensor_t<int8_t> *act, TensorArray_t<int8_t> *filtSet, const conv2DParams_t& params, const PackedFilters_t<int8_t> *packedFiltSet, 
+		const hwMMepilogue_t *epilogue, const convBand_t *band) {
+	if (option_dataflow != CONV_FLOW_AUTO)
+		return option_dataflow;
+	hwMMepilogue_t wrap(HWMM_ACC_WRAP8, filtSet->count());
+	const PackedFilters_t<int8_t> *packed = packedFiltSet;
+	if (packed == NULL)
+		packed = new PackedFilters_t<int8_t>(*filtSet, hwMM.P, params.groups, option_groupPack, option_sparse);
+	int flow = selectDataflow(act, filtSet, params, packed, epilogue ? *epilogue : wrap, band);
+	if (packed != packedFiltSet)
+		delete packed;
+	return flow;
+}
+
+// simulatedConv2DBatch: simulate 2D convolution of a batch of activation tensors (all of the same shape) against one filter set.
+// This is weight stationary: each P x P filter tile is loaded into the simulated multiplier once per channel tile and slice, 
+// and the surface vectors of every image in the batch are streamed through it. The output positions of all images are 
+// treated as one long "batch surface", so a group of N input vectors may span two images and only the last group of the 
+// whole batch has idle rows. Since every output position is now accumulated across the slice loop, the accumulators for 
+// all positions of a unit are kept (in "hwMMres") until the last slice; they are stored to the result set after that.
+// Slices are always gathered implicitly. Results are identical to running simulatedConv2D() on each image.
+//
+// Units for the scheduler are (channel tile, batch surface chunk) pairs; the batch surface is only split into chunks when 
+// there are fewer channel tiles than threads (or engines), and each chunk loads its filter tiles once. With hwMM.engines > 0,
+// the units run on modeled engines as in simulatedConv2D(), double buffered with option_pipeline (the host simulation of
+// a batch is not pipelined).
+
+TensorArray_t<int8_t> *simulatedConv2DBatch(TensorArray_t<int8_t> *acts, TensorArray_t<int8_t> *filtSet, const conv2DParams_t& params, const PackedFilters_t<int8_t> *packedFiltSet, 
+		hwMMcounters_t *counters, const hwMMepilogue_t *epilogue) { 
+	hwMMkernel_t hwMMmultiply = hwMMselectKernel(option_kernel, option_specialize ? hwMM.P : 0);
+	hwMMepilogue_t wrap(HWMM_ACC_WRAP8, filtSet->count());
+	const hwMMepilogue_t& epi = epilogue ? *epilogue : wrap;
+	bool saturate = epi.accum == HWMM_ACC_SAT8;
+	TileScheduler_t scheduler(option_threads);
+
+	// pack the filters into multiplier tiles unless the caller supplied a packed set for this layer
+	const PackedFilters_t<int8_t> *packed = packedFiltSet;
+	if (packed == NULL)
+		packed = new PackedFilters_t<int8_t>(*filtSet, hwMM.P, params.groups, option_groupPack, option_sparse);
+	assert(packed->matches(*filtSet, hwMM.P, params.groups) && acts->depth() == filtSet->depth() * params.groups && acts->layout() == filtSet->layout());
+
+	// compute output tensor dimensions
+	int B = acts->count();
+	conv2DGeometry_t geom(acts->width(), acts->height(), filtSet->width(), filtSet->height(), params);
+	int OW = geom.OW;
+	int OH = geom.OH;
+	int OS = OW * OH;									// output surface count (per image)
+	int OD = filtSet->count();
+	TensorArray_t<int8_t>* res = new TensorArray_t<int8_t>(B, OW, OH, OD, acts->layout());
+
+	// split the batch surface in N-vector groups, and the groups in chunks
+	int BS = B * OS;									// batch surface count
+	int vectorGroups = (BS + hwMM.N - 1) / hwMM.N;
+	int channelTiles = packed->channelTiles();
+	int slots = engineSlots(scheduler, hwMM.engines);
+	int chunks = (slots + channelTiles - 1) / channelTiles; if (chunks > vectorGroups) chunks = vectorGroups;
+	int chunkGroups = (vectorGroups + chunks - 1) / chunks;
+
+	// model the HW matrices and vector arrays, one set per host thread (or engine); "hwMMres" holds the accumulators of a whole chunk
+	std::vector<Matrix_t<int8_t> *> hwMMvectorState(slots), hwMMoutState(slots);
+	std::vector<Matrix_t<int32_t> *> hwMMresState(slots), hwMMpartialState(slots);
+	std::vector<hwMMcounters_t> counterState(slots);
+	std::vector<EngineTrace_t> traceState(slots);
+	for (int t = 0; t < slots; t++) {
+		hwMMvectorState[t] = new Matrix_t<int8_t>(hwMM.P, hwMM.N);
+		hwMMresState[t] = new Matrix_t<int32_t>(hwMM.P, chunkGroups * hwMM.N);
+		hwMMpartialState[t] = new Matrix_t<int32_t>(hwMM.P, hwMM.N);
+		hwMMoutState[t] = new Matrix_t<int8_t>(hwMM.P, chunkGroups * hwMM.N);
+	}
+
+	runOnEngines(scheduler, hwMM.engines, channelTiles * chunks, [&](int unit, int slot) {
+		Matrix_t<int8_t>& hwMMvectors = *hwMMvectorState[slot];
+		Matrix_t<int32_t>& hwMMres = *hwMMresState[slot];
+		Matrix_t<int32_t>& hwMMpartial = *hwMMpartialState[slot];
+		Matrix_t<int8_t>& hwMMout = *hwMMoutState[slot];
+		hwMMcounters_t& count = counterState[slot];
+		const int8_t *hwMMmatrix;
+		int ct = unit / chunks;
+		int g0 = (int) ((long) (unit % chunks) * vectorGroups / chunks);
+		int g1 = (int) ((long) (unit % chunks + 1) * vectorGroups / chunks);
+
+		// grab up to next Q serialized filters for channel, and the activation channels [k, k + KD) they read
+		int c = packed->tileChannel(ct);
+		int chanCount = packed->tileChannels(ct);
+		int k = packed->tileInputChannel(ct), KD = packed->tileInputDepth(ct);
+		int VL = packed->tileLength(ct);
 
-			// store the completed accumulators in the result tensor
-			for (int ss = 0; ss < osLen; ss++) {
-				for (int cc = 0; cc < chanCount; cc++) {
-					int ii = (s+ss) % OW; int jj = (s+ss) / OW; 
-					(*res)(ii, jj, c+cc) = hwMMres(ss, cc);
+		// init HW MM result matrix (the accumulators)
+		hwMMres.setMatrix2constant(0);
+
+		// For each P-sized slice of the P serialized filters with a nonzero tile, load the filter tile once...
+		for (int b = packed->firstBlock(ct); b < packed->endBlock(ct); b++) {
+			int ijk = packed->blockSlice(b) * hwMM.P;
+			int sliceLen = VL - ijk; if (sliceLen > hwMM.P) sliceLen = hwMM.P;
+			int work = packed->tileWork(ct, ijk / hwMM.P);
+			hwMMmatrix = packed->block(b);
+			count.loadMatrix(hwMM.P);
+
+			// ...and stream every group of up to N batch surface vectors of the chunk through it
+			for (int g = g0; g < g1; g++) {
+				int vecLen = BS - g * hwMM.N; if (vecLen > hwMM.N) vecLen = hwMM.N;
+				for (int v = 0; v < vecLen; v++) {
+					int b = (g * hwMM.N + v) / OS; int pos = (g * hwMM.N + v) % OS;
+					gatherSubtensorSlice(hwMMvectors.pointer(v), hwMM.P, (*acts)[b], geom.originW(pos % OW), geom.originH(pos / OW), k, filtSet->width(), filtSet->height(), KD, 
+							ijk, sliceLen, params.dilationW, params.dilationH);
 				}
+				if (saturate) {
+					memset(hwMMpartial.pointer(), 0, vecLen * hwMM.P * sizeof(int32_t));
+					hwMMmultiply(hwMMpartial.pointer(), hwMMvectors.pointer(), hwMMmatrix, vecLen, hwMM.P);
+					hwMMsaturate(hwMMres.pointer((g - g0) * hwMM.N), hwMMpartial.pointer(), vecLen * hwMM.P);
+				} else
+					hwMMmultiply(hwMMres.pointer((g - g0) * hwMM.N), hwMMvectors.pointer(), hwMMmatrix, vecLen, hwMM.P);
+				count.loadVectors(hwMM.P, vecLen);
+				count.invoke(hwMM.N, hwMM.P, vecLen, chanCount, sliceLen, work);
+				if (hwMM.engines)
+					traceState[slot].step(count, engineStepCycles(hwMM.N));
+			}
+		}
+		count.skip((packed->tileSlices(ct) - (packed->endBlock(ct) - packed->firstBlock(ct))) * (g1 - g0));
+
+		// run the completed accumulators through the epilogue and store them in the result tensors
+		int rows = (g1 * hwMM.N < BS ? g1 * hwMM.N : BS) - g0 * hwMM.N;
+		epi.store(hwMMout.pointer(), hwMMres.pointer(), rows, hwMM.P, c, chanCount);
+		for (int v = 0; v < rows; v++) {
+			int b = (g0 * hwMM.N + v) / OS; int pos = (g0 * hwMM.N + v) % OS;
+			if (res->layout() == TENSOR_LAYOUT_HWC)
+				memcpy(res->buffer() + b * res->stride() + pos * OD + c, hwMMout.pointer(v), chanCount);
+			else {
+				int8_t *dst = res->buffer() + b * res->stride() + c * OS + pos;
+				for (int cc = 0; cc < chanCount; cc++)
+					dst[cc * OS] = hwMMout(cc, v);
 			}
 		}
+		count.writeback(rows * chanCount);
+	});
+
+	// cleanup; sum up the per-thread counters, and model the engines
+	if (counters) {
+		std::vector<const EngineTrace_t *> traces;
+		counters->clear();
+		for (int t = 0; t < slots; t++) {
+			*counters += counterState[t];
+			traces.push_back(&traceState[t]);
+		}
+		if (hwMM.engines)
+			modelEngines(traces, hwMM.loadBytes, option_pipeline ? 2 : 1, *counters);
+	}
+	for (int t = 0; t < slots; t++) {
+		delete hwMMvectorState[t];
+		delete hwMMresState[t];
+		delete hwMMpartialState[t];
+		delete hwMMoutState[t];
 	}
+	if (packed != packedFiltSet)
+		delete packed;
 	return res; 
 }
 
 // referenceConv2D: much simpler than simulatedConv2D() as we do not need to serialize or slice the tensors.
-// We wimply do the convolutions in 2D by extracting subtensors from the activation tensor and doing
-// a direct dot product of the activation subtensor against each filter tensor.
+// We simply do the convolutions in 2D by dotting the activation window of each output element directly against 
+// each filter tensor. Stride, dilation and padding follow conv2DGeometry_t; taps in the padding read as 0. 
+// Filters of group g read activation channels from g * filter depth on (see conv2DParams_t).
+// The sum runs in serialized (depth, height, width) order, the same order as Tensor_t::dot().
 
-Tensor_t<float> *referenceConv2D(Tensor_t<float> *act, TensorArray_t<float> *filtSet) { 
+Tensor_t<float> *referenceConv2D(Tensor_t<float> *act, TensorArray_t<float> *filtSet, const conv2DParams_t& params) { 
 	// compute output tensor dimensions
-	int OW = act->width() - filtSet->width() + 1;
-	int OH = act->height() - filtSet->height() + 1;
-	int OS = OW * OH;									// output surface count
+	conv2DGeometry_t geom(act->width(), act->height(), filtSet->width(), filtSet->height(), params);
+	int OW = geom.OW;
+	int OH = geom.OH;
 	int OC = filtSet->count();
+	int KD = filtSet->depth();
 
 	Tensor_t<float>* res = new Tensor_t<float>(OW, OH, OC);
 	for (int c = 0; c < OC; c++) 
 		for (int i = 0; i < OW; i++)
-			for (int j = 0; j < OH; j++)
-				(*res)(i, j, c) = (*filtSet)[c].dot(act->extractSubtensor(i, j, 0, filtSet->width(), filtSet->height(), filtSet->depth()));
+			for (int j = 0; j < OH; j++) {
+				float sum = 0;
+				int k0 = (c / (OC / params.groups)) * KD;			// first activation channel of the filter's group
+				for (int k = 0; k < KD; k++)
+					for (int y = 0; y < filtSet->height(); y++) {
+						int jj = geom.originH(j) + y * params.dilationH;
+						if (jj < 0 || jj >= act->height())
+							continue;
+						for (int x = 0; x < filtSet->width(); x++) {
+							int ii = geom.originW(i) + x * params.dilationW;
+							if (ii >= 0 && ii < act->width())
+								sum += (*filtSet)[c](x, y, k) * (*act)(ii, jj, k0 + k);
+						}
+					}
+				(*res)(i, j, c) = sum;
+			}
 	return res; 
 }
 
-// compute the RMS error between a fixed point simulated tensor and a float reference tensor
-float compareTensors(Tensor_t<int8_t> *sTensor, Tensor_t<float> *rTensor) { 
+// compute the RMS error between a fixed point simulated tensor and a float reference tensor; 
+// with an epilogue, against the ideal outputs for the reference sums
+float compareTensors(Tensor_t<int8_t> *sTensor, Tensor_t<float> *rTensor, const hwMMepilogue_t *epi) { 
 	float error = 0.0;
 
 	int W = sTensor->width();
@@ -289,7 +1251,7 @@ float compareTensors(Tensor_t<int8_t> *sTensor, Tensor_t<float> *rTensor) {
 	for (int i = 0; i < W; i++)
 		for (int j = 0; j < H; j++)
 			for (int k = 0; k < D; k++)
-				error += pow((float) (*sTensor)(i,j,k) - (*rTensor)(i,j,k), 2.0);
+				error += pow((float) (*sTensor)(i,j,k) - (epi ? epi->ideal((*rTensor)(i,j,k), k) : (*rTensor)(i,j,k)), 2.0);
 	return pow(error / ((float) (W * H * D)), 0.5); 
 }
 
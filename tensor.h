@@ -11,17 +11,97 @@
 #include <assert.h>
 #include <sstream>
 #include <string>
+#include "arena.h"
+#include "csv.h"
 #include <type_traits>
+#include <cstring>
+#include <utility>
 #include "vector.h"
 #include "matrix.h"
 
+// a tensor element as CSV text: integers as (int), floats per the writer's precision
+template <typename T>
+inline void csvPut(CsvWriter_t& w, T v) {
+	if (std::is_floating_point<T>::value)
+		w.put((double) v);
+	else
+		w.put((int64_t) v);
+}
+
+// element orders of a tensor in memory (also recorded in tensor files, see tensorfile.h)
+enum tensorLayout_t {
+	TENSOR_LAYOUT_CHW = 0,		// channel first: element (i, j, k) at ((k * H) + j) * W + i
+	TENSOR_LAYOUT_HWC = 1		// channel last: element (i, j, k) at ((j * W) + i) * D + k
+};
+inline const char *tensorLayoutName(int layout) { return layout == TENSOR_LAYOUT_HWC ? "hwc" : "chw"; }
+
+// convertLayout: copy a W x H x D tensor at "src" in layout "from" to "dst" in layout "to"
+template <typename T>
+inline void convertLayout(T *dst, tensorLayout_t to, const T *src, tensorLayout_t from, int W, int H, int D) {
+	if (to == from) {
+		memcpy(dst, src, W * H * D * sizeof(T));
+		return;
+	}
+	// one side is CHW, the other HWC: walk the CHW side in order
+	for (int k = 0; k < D; k++)
+		for (int j = 0; j < H; j++)
+			for (int i = 0; i < W; i++) {
+				int chw = ((k * H) + j) * W + i, hwc = ((j * W) + i) * D + k;
+				if (from == TENSOR_LAYOUT_CHW)
+					dst[hwc] = src[chw];
+				else
+					dst[chw] = src[hwc];
+			}
+}
+
+// TensorView_t class
+// A non-owning view of a W x H x D window of a tensor; element (i, j, k) is data[k * planeStride + j * rowStride + i], 
+// so rows of the window stay contiguous. Taking a view copies nothing; it is only valid while the tensor lives.
+template <typename T>
+class TensorView_t {
+public:
+	// Constructor
+	TensorView_t(T *_data, int _W, int _H, int _D, int _rowStride, int _planeStride) : 
+		data(_data), W(_W), H(_H), D(_D), len(_W * _H * _D), rowStride(_rowStride), planeStride(_planeStride) {}
+
+	// dimension methods
+	inline const int width() const { return W; }
+	inline const int height() const { return H; }
+	inline const int depth() const { return D; }
+	inline const int length() const { return len; }
+
+	// reference to a view member
+	inline T& operator()(int i, int j, int k) const { 
+		assert(i >= 0 && i < W && j >= 0 && j < H && k >= 0 && k < D); 
+		return data[k * planeStride + j * rowStride + i]; 
+	}
+
+	// row j at depth k as a vector view
+	inline VectorView_t<T> row(int j, int k) const { return VectorView_t<T>(&(*this)(0, j, k), W); }
+
+	// view of a window of this view
+	TensorView_t<T> view(const int ii, const int jj, const int kk, const int w, const int h, const int d) const {
+		assert(ii >= 0 && jj >= 0 && kk >= 0 && w >= 1 && h >= 1 && d >= 1 && (ii + w) <= W && (jj + h) <= H && (kk + d) <= D);
+		return TensorView_t<T>(&data[kk * planeStride + jj * rowStride + ii], w, h, d, rowStride, planeStride);
+	}
+
+private:
+	T *data;
+	int W, H, D;
+	int len;
+	int rowStride, planeStride;
+};
+
 // Tensor_t class
+// The elements are stored in one of the layouts of tensorLayout_t, channel first (the default) or channel last. operator()
+// hides the layout; the raw buffer, serialization and the gathers of implicit GEMM follow it (see serializeTensor2Vector()).
 template <typename T>
 class Tensor_t {
 public:
 	// constructor
-	Tensor_t(int _W = 1, int _H = 1, int _D = 1) : W(_W), H(_H), D(_D), len(_W * _H * _D) {
-		data = new T[len];
+	Tensor_t(int _W = 1, int _H = 1, int _D = 1, tensorLayout_t _order = TENSOR_LAYOUT_CHW) :
+		owner(true), W(_W), H(_H), D(_D), len(_W * _H * _D), order(_order) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), len);
 		T *dst = data;
 
 		for (int i = 0; i < W; i++)
@@ -33,8 +113,8 @@ public:
 	// generic copy constructor
 	template <typename U> friend class Tensor_t;
 	template <typename U>
-	Tensor_t(const Tensor_t<U>& t) : W(t.W), H(t.H), D(t.D), len(t.len) { 
-		data = new T[t.length()];
+	Tensor_t(const Tensor_t<U>& t) : owner(true), W(t.W), H(t.H), D(t.D), len(t.len), order(t.order) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), t.length());
 		T *dst = data;
 		U *src = t.data;
 
@@ -44,86 +124,197 @@ public:
 					*dst++ = (T) *src++;
 	}
 
+	// constructor on borrowed storage: wraps W * H * D elements at "storage" (not zeroed, not freed). 
+	// Used by TensorArray_t for the tensors in its contiguous buffer.
+	Tensor_t(T *storage, int _W, int _H, int _D, tensorLayout_t _order = TENSOR_LAYOUT_CHW) :
+		data(storage), arena(NULL), owner(false), W(_W), H(_H), D(_D), len(_W * _H * _D), order(_order) {}
+
+	// copy constructor
+	Tensor_t(const Tensor_t<T>& t) : owner(true), W(t.W), H(t.H), D(t.D), len(t.len), order(t.order) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), len);
+		memcpy(data, t.data, len * sizeof(T));
+	}
+
+	// layout converting constructor: a copy of "t" stored in layout "to"
+	Tensor_t(const Tensor_t<T>& t, tensorLayout_t to) : owner(true), W(t.W), H(t.H), D(t.D), len(t.len), order(to) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), len);
+		convertLayout(data, order, t.data, t.order, W, H, D);
+	}
+
+	// move constructor; takes over the storage of "t"
+	Tensor_t(Tensor_t<T>&& t) : data(t.data), arena(t.arena), owner(t.owner), W(t.W), H(t.H), D(t.D), len(t.len), order(t.order) {
+		t.data = NULL;
+		t.arena = NULL;
+		t.W = t.H = t.D = t.len = 0;
+	}
+
+	// materializing constructor; copies the elements of a view row by row
+	explicit Tensor_t(const TensorView_t<T>& v) : owner(true), W(v.width()), H(v.height()), D(v.depth()), len(v.length()), order(TENSOR_LAYOUT_CHW) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), len);
+		T *dst = data;
+
+		for (int k = 0; k < D; k++)
+			for (int j = 0; j < H; j++, dst += W)
+				memcpy(dst, v.row(j, k).pointer(), W * sizeof(T));
+	}
+
 	// destructor
-	virtual ~Tensor_t() { delete[] data; }
+	virtual ~Tensor_t() { if (owner) arenaFree(arena, data); }
+
+	// assignment: copy (deep) and move. A tensor on borrowed storage is overwritten in place instead.
+	Tensor_t<T>& operator= (const Tensor_t<T>& t) {
+		if (this != &t) {
+			if (!owner) {
+				assert(W == t.W && H == t.H && D == t.D);
+				convertLayout(data, order, t.data, t.order, W, H, D);
+			} else {
+				Tensor_t<T> copy(t);
+				swap(copy);
+			}
+		}
+		return *this;
+	}
+	Tensor_t<T>& operator= (Tensor_t<T>&& t) {
+		if (this != &t) {
+			if (!owner || !t.owner)
+				*this = (const Tensor_t<T>&) t;
+			else
+				swap(t);
+		}
+		return *this;
+	}
+
+	// exchange contents with another tensor
+	void swap(Tensor_t<T>& t) {
+		std::swap(data, t.data);
+		std::swap(arena, t.arena);
+		std::swap(owner, t.owner);
+		std::swap(W, t.W);
+		std::swap(H, t.H);
+		std::swap(D, t.D);
+		std::swap(len, t.len);
+		std::swap(order, t.order);
+	}
 
 	// dimension methods
 	inline const int width() const { return W; }
 	inline const int height() const { return H; }
 	inline const int depth() const { return D; }
 	inline const int length() const { return len; }
-	
+
+	// layout, and the distance in elements between neighbouring columns and between neighbouring channels
+	inline tensorLayout_t layout() const { return order; }
+	inline int columnStride() const { return order == TENSOR_LAYOUT_CHW ? 1 : D; }
+	inline int channelStride() const { return order == TENSOR_LAYOUT_CHW ? W * H : 1; }
+
 	// reference to a tensor member
-	inline T& operator()(int i, int j, int k) const { 
-		assert(i >= 0 && i < W && j >= 0 && j < H && k >= 0 && k < D); 
-		return data[((k * H) + j) * W + i]; 
+	inline T& operator()(int i, int j, int k) const {
+		assert(i >= 0 && i < W && j >= 0 && j < H && k >= 0 && k < D);
+		return data[order == TENSOR_LAYOUT_CHW ? ((k * H) + j) * W + i : ((j * W) + i) * D + k];
 	}
 
-	// Extract a subtensor slice from tensor of spatial face h by w, full depth
-	Tensor_t<T> extractSubtensor(const int ii, const int jj, const int kk, const int w, const int h, const int d) const {
-		Tensor_t<T> result(w, h, d);
+	// a copy of the tensor stored in layout "to"
+	Tensor_t<T> toLayout(tensorLayout_t to) const { return Tensor_t<T>(*this, to); }
 
+	// non-owning view of the whole tensor or of a subtensor window; nothing is copied. Views describe channel planes,
+	// so they are only available on channel first tensors.
+	TensorView_t<T> view() const { assert(order == TENSOR_LAYOUT_CHW); return TensorView_t<T>(data, W, H, D, W, W * H); }
+	TensorView_t<T> view(const int ii, const int jj, const int kk, const int w, const int h, const int d) const {
 		// parameter check
+		assert(order == TENSOR_LAYOUT_CHW);
 		assert(ii >= 0 && jj >= 0 && kk >= 0 &&								// offsets >= 0
 			ii < W && jj < H && kk < D && 									// offsets less than dimensions
 			w >= 1 && h >= 1 && d >= 1 && 									// output dimensions positive and non-zero
 			(ii + w) <= W && (jj + h) <= H && (kk + d) <= D);				// output not sliced beyond limits
+		return TensorView_t<T>(&data[((kk * H) + jj) * W + ii], w, h, d, W, W * H);
+	}
 
-		// We copy from rows innermost, to columns, to depth. 
-		// Since we are extracting a partial row, we align to start of next offset when copy is complete (when we started, we were at ii offset; 
-		// we increment during the copy to now be at "ii + w" offset - row end is at "W - ii - w" distance; we want to take that distance and
-		// then add ii to offset at the next row => "W - ii - w + ii" = "W - w" adder. Since we are copying complete depth, we don't need to do this
-		// for the loop after stride H. 
-		for (int i = 0; i < w; i++)
-			for (int j = 0; j < h; j++) 
-				for (int k = 0; k < d; k++) 
-					result(i, j, k) = (*this)(ii+i, jj+j, kk+k);
-		return result;
+	// Extract a subtensor slice from tensor of spatial face h by w, full depth.
+	// This is a copy of view(ii, jj, kk, w, h, d) in the layout of this tensor; the result is moved out, not copied again.
+	Tensor_t<T> extractSubtensor(const int ii, const int jj, const int kk, const int w, const int h, const int d) const {
+		if (order == TENSOR_LAYOUT_CHW)
+			return Tensor_t<T>(view(ii, jj, kk, w, h, d));
+		assert(ii >= 0 && jj >= 0 && kk >= 0 && w >= 1 && h >= 1 && d >= 1 && (ii + w) <= W && (jj + h) <= H && (kk + d) <= D);
+		Tensor_t<T> sub(w, h, d, order);
+		T *dst = sub.data;
+		for (int j = 0; j < h; j++) {
+			const T *src = &data[(((jj + j) * W) + ii) * D + kk];
+			if (d == D) {
+				memcpy(dst, src, w * d * sizeof(T));
+				dst += w * d;
+			} else
+				for (int i = 0; i < w; i++, dst += d, src += D)
+					memcpy(dst, src, d * sizeof(T));
+		}
+		return sub;
 	}
 
-	// Dot two tensors (dot product)
+	// Dot two tensors of the same layout (dot product)
 	T dot(const Tensor_t<T>& t) const {
 		T sum = 0;
 		T *src1 = t.data;
 		T *src2 = data;
 
-		assert(W == t.W && H == t.H && D == t.D);
+		assert(W == t.W && H == t.H && D == t.D && order == t.order);
 		for (int l = 0; l < len; l++)
 			sum += *src1++ * *src2++;
 		return sum;
 	}
 
+	// Dot a tensor with a view of the same shape (e.g. a subtensor window), in serialized order
+	T dot(const TensorView_t<T>& v) const {
+		T sum = 0;
+		T *src2 = data;
+
+		assert(W == v.width() && H == v.height() && D == v.depth() && order == TENSOR_LAYOUT_CHW);
+		for (int k = 0; k < D; k++)
+			for (int j = 0; j < H; j++) {
+				T *src1 = v.row(j, k).pointer();
+				for (int i = 0; i < W; i++)
+					sum += *src1++ * *src2++;
+			}
+		return sum;
+	}
+
 	// generate a string with geometry info
     std::string operator() () const {
-	   	static std::ostringstream buffer;
+	   	std::ostringstream buffer;
 	    buffer << "[" << W << "," << H << "," << D << "]";
 	    return buffer.str();
     }
 
-    // CSV dump
-    void csvDump(std::ostream& os, const char* name = NULL) {
+    // CSV dump: a header line, then one line per (i, j) with the D values of that position
+    void csvDump(std::ostream& os, const char* name = NULL) const {
+    	CsvWriter_t w(os);
+    	csvDump(w, name);
+    }
+    void csvDump(CsvWriter_t& w, const char* name = NULL) const {
     	// print optional array name
-    	if (name != NULL)
-    		os << name << std::endl;
+    	if (name != NULL) {
+    		w.put(name);
+    		w.endl();
+    	}
 
     	// print header
-    	os << std::dec;
-     	os << "WH";
-	   	for (int k = 0; k < D; k++)
-    		os << "," << k;
-    	os << std::endl;
+     	w.put("WH");
+	   	for (int k = 0; k < D; k++) {
+	   		w.put(',');
+    		w.put(k);
+	   	}
+    	w.endl();
 
     	// print tensor
     	for (int i = 0; i < W; i++) {
     		for (int j = 0; j < H; j++) {
-    			os << i << "x" << j;
-		    	for (int k = 0; k < D; k++) {
-		    		if (std::is_floating_point<T>::value)
-		    			os << "," << (*this)(i, j, k);
-		    		else
-		    			os << "," << (int) (*this)(i, j, k);
+    			const T *src = &(*this)(i, j, 0);
+    			w.put(i);
+    			w.put('x');
+    			w.put(j);
+		    	for (int k = 0; k < D; k++, src += channelStride()) {
+		    		w.put(',');
+		    		csvPut(w, *src);
 		    	}
-		    	os << std::endl;
+		    	w.endl();
 	   		}
     	}
     }
@@ -131,14 +322,25 @@ public:
     // define pointer type
     typedef Tensor_t *TensorPtr_t;
 
-	// friend function to serialize a Tensor into a vector
+	// friend functions to serialize a Tensor into a vector
     template <typename U>
 	friend void serializeTensor2Vector(Vector_t<U> &, const Tensor_t<U> &);
+    template <typename U>
+	friend void serializeTensor2Vector(Vector_t<U> &, const TensorView_t<U> &);
+
+	// friend function to gather a slice of a serialized subtensor directly from a tensor
+    template <typename U>
+	friend void gatherSubtensorSlice(U *, int, const Tensor_t<U> &, int, int, int, int, int, int, int, int, int, int);
+    template <typename U>
+	friend void gatherSubtensorSliceHWC(U *, int, const Tensor_t<U> &, int, int, int, int, int, int, int, int, int);
 
 private:
 	T *data;
-	const int W, H, D;
-	const int len;
+	Arena_t *arena;		// where "data" came from (NULL = heap)
+	bool owner;			// false if "data" is borrowed storage
+	int W, H, D;
+	int len;
+	tensorLayout_t order;
 
 	template <typename TT> friend class Vector_t;
 	template <typename TT> friend class Matrix_t;
@@ -146,44 +348,179 @@ private:
 
 // Tensor_t Friend Functions
 // friend function to serialize a Tensor into a vector
-// The data in a tensor is already serialized by row-col-depth, so all we have to do is copy it. 
+// The data in a tensor is already serialized in its layout (row-col-depth for CHW, depth-col-row for HWC), so all we
+// have to do is copy it. Filters and the activation windows they are dotted with must therefore share a layout.
 // (a bit of overhead since we zero-initialize a vector in the constructor)
 template <typename T> 
 inline void serializeTensor2Vector(Vector_t<T>& dst, const Tensor_t<T>& src) {
 	assert(dst.length() == src.length());
-	memcpy(dst.data, src.data, src.length());
+	memcpy(dst.data, src.data, src.length() * sizeof(T));
+}
+
+// serialize a tensor view (e.g. a subtensor window) into a vector without materializing it first
+template <typename T> 
+inline void serializeTensor2Vector(Vector_t<T>& dst, const TensorView_t<T>& src) {
+	assert(dst.length() == src.length());
+	T *out = dst.data;
+	for (int k = 0; k < src.depth(); k++)
+		for (int j = 0; j < src.height(); j++, out += src.width())
+			memcpy(out, src.row(j, k).pointer(), src.width() * sizeof(T));
+}
+
+// gatherSubtensorSlice() of a channel last source: runs are the channels of one window position, or a whole window
+// row when the window spans the full depth, is not dilated horizontally and the row lies inside the source
+template <typename T>
+inline void gatherSubtensorSliceHWC(T *dst, int dstLen, const Tensor_t<T>& src, int ii, int jj, int kk, int w, int d, int offset, int len, int dw, int dh) {
+	// position of the first element in subtensor coordinates
+	int k = offset % d;
+	int i = (offset / d) % w;
+	int j = offset / (w * d);
+	T *out = dst;
+
+	// whole rows are contiguous when the window spans the depth and its columns are adjacent and inside the source
+	bool rows = d == src.D && dw == 1 && ii >= 0 && (ii + w - 1) < src.W;
+
+	// copy runs until the slice is complete
+	for (int remaining = len; remaining > 0; ) {
+		int y = jj + j * dh;
+		bool rowInside = y >= 0 && y < src.H;
+		int run;
+		if (rows && rowInside) {
+			run = (w - i) * d - k; if (run > remaining) run = remaining;
+			memcpy(out, &src.data[((y * src.W) + ii + i) * src.D + kk + k], run * sizeof(T));
+			i = w;
+		} else {
+			run = d - k; if (run > remaining) run = remaining;
+			int x = ii + i * dw;
+			if (rowInside && x >= 0 && x < src.W)
+				memcpy(out, &src.data[((y * src.W) + x) * src.D + kk + k], run * sizeof(T));
+			else
+				memset(out, 0, run * sizeof(T));
+			i++;
+		}
+		out += run;
+		remaining -= run;
+		k = 0;
+		if (i == w) { i = 0; j++; }
+	}
+
+	// zero the unused tail of the destination
+	if (len < dstLen)
+		memset(out, 0, (dstLen - len) * sizeof(T));
+}
+
+// friend function to gather a slice of a serialized subtensor directly from a tensor (implicit GEMM).
+// The result is the same as serializeTensor2Vector() on src.extractSubtensor(ii, jj, kk, w, h, d) followed by
+// extractVecSlice(offset, len) into a zeroed vector, but nothing is allocated: serialized offset l maps back to
+// subtensor element (l % w, (l / w) % h, l / (w * h)), and since width varies fastest in both, each subtensor row is
+// a contiguous run in a CHW source. In an HWC source, l maps to ((l / d) % w, l / (w * d), l % d): the d channels of
+// a position are a contiguous run, and a window row spanning the full depth is a single contiguous run of w * d.
+// Destination elements [len, dstLen) are zeroed.
+//
+// The window may also be dilated (element (i, j, k) is read from (ii + i * dw, jj + j * dh, kk + k)) and may reach 
+// outside the source tensor, in which case the missing elements read as 0. This is how padding is applied virtually, 
+// without building a padded copy of the tensor.
+template <typename T>
+inline void gatherSubtensorSlice(T *dst, int dstLen, const Tensor_t<T>& src, int ii, int jj, int kk, int w, int h, int d, int offset, int len, int dw = 1, int dh = 1) {
+	assert(kk >= 0 && (kk + d) <= src.D && dw >= 1 && dh >= 1);
+	assert(offset >= 0 && len > 0 && (offset + len) <= w * h * d && len <= dstLen);
+	if (src.order == TENSOR_LAYOUT_HWC) {
+		gatherSubtensorSliceHWC(dst, dstLen, src, ii, jj, kk, w, d, offset, len, dw, dh);
+		return;
+	}
+
+	// position of the first element in subtensor coordinates
+	int i = offset % w;
+	int j = (offset / w) % h;
+	int k = offset / (w * h);
+	T *out = dst;
+
+	// window fully inside the source and not dilated horizontally: rows are contiguous runs
+	bool inside = ii >= 0 && jj >= 0 && (ii + (w - 1) * dw) < src.W && (jj + (h - 1) * dh) < src.H;
+
+	// copy row runs until the slice is complete
+	for (int remaining = len; remaining > 0; ) {
+		int run = w - i; if (run > remaining) run = remaining;
+		int y = jj + j * dh;
+		if (inside && dw == 1) 
+			memcpy(out, &src.data[(((kk + k) * src.H) + y) * src.W + ii + i], run * sizeof(T));
+		else if (y < 0 || y >= src.H)
+			memset(out, 0, run * sizeof(T));
+		else {
+			const T *row = &src.data[((kk + k) * src.H + y) * src.W];
+			for (int r = 0; r < run; r++) {
+				int x = ii + (i + r) * dw;
+				out[r] = (x >= 0 && x < src.W) ? row[x] : 0;
+			}
+		}
+		out += run;
+		remaining -= run;
+		i = 0;
+		if (++j == h) { j = 0; k++; }
+	}
+
+	// zero the unused tail of the destination
+	if (len < dstLen)
+		memset(out, 0, (dstLen - len) * sizeof(T));
 }
 
 // TensorArray_t class
+// The N tensors live back to back in one 64-byte aligned buffer; tensor i starts at buffer() + i * stride(). 
+// The buffer can be handed as is to a kernel or a writer. operator[] returns a Tensor_t on that storage. All the
+// tensors share one layout.
 template <typename T>
 class TensorArray_t {
 public:
 	// Constructor
-	TensorArray_t(int _N = 1, int _W = 1, int _H = 1, int _D = 1) : N(_N), W(_W), H(_H), D(_D), len(_W * _H * _D) {
-		array = new typename Tensor_t<T>::TensorPtr_t[N];
-		for (int i = 0; i < N; i++)
-			array[i] = new Tensor_t<T>(W, H, D);
+	TensorArray_t(int _N = 1, int _W = 1, int _H = 1, int _D = 1, tensorLayout_t _order = TENSOR_LAYOUT_CHW) :
+		owner(true), W(_W), H(_H), D(_D), len(_W * _H * _D), N(_N), order(_order) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), N * len);
+		memset(data, 0, N * len * sizeof(T));
+		bind();
+	}
+
+	// constructor on borrowed storage: wraps N tensors of W * H * D elements, back to back at "storage" (not zeroed, 
+	// not freed), e.g. the payload of a memory mapped tensor file
+	TensorArray_t(T *storage, int _N, int _W, int _H, int _D, tensorLayout_t _order = TENSOR_LAYOUT_CHW) :
+		data(storage), arena(NULL), owner(false), W(_W), H(_H), D(_D), len(_W * _H * _D), N(_N), order(_order) {
+		bind();
 	}
 
 	// generic copy constructor
 	template <typename U> friend class TensorArray_t;
 	template <typename U>
-	TensorArray_t(const TensorArray_t<U>& t) : N(t.N), W(t.W), H(t.H), D(t.D), len(t.len) { 
-		array = new typename Tensor_t<T>::TensorPtr_t[t.N];
-		for (int i = 0; i < N; i++)
-			array[i] = new Tensor_t<T>(*t.array[i]);
+	TensorArray_t(const TensorArray_t<U>& t) : owner(true), W(t.W), H(t.H), D(t.D), len(t.len), N(t.N), order(t.order) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), N * len);
+		for (int i = 0; i < N * len; i++)
+			data[i] = (T) t.data[i];
+		bind();
 	}
 
-	// Destructor
-	virtual ~TensorArray_t() {
-		for (int i = 0; i < N; i++)
-			delete array[i];
-		delete[] array;
+	// copy constructor
+	TensorArray_t(const TensorArray_t<T>& t) : owner(true), W(t.W), H(t.H), D(t.D), len(t.len), N(t.N), order(t.order) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), N * len);
+		memcpy(data, t.data, N * len * sizeof(T));
+		bind();
 	}
 
+	// layout converting constructor: a copy of "t" with every tensor stored in layout "to"
+	TensorArray_t(const TensorArray_t<T>& t, tensorLayout_t to) : owner(true), W(t.W), H(t.H), D(t.D), len(t.len), N(t.N), order(to) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), N * len);
+		for (int n = 0; n < N; n++)
+			convertLayout(&data[n * len], order, &t.data[n * len], t.order, W, H, D);
+		bind();
+	}
+
+	// Destructor
+	virtual ~TensorArray_t() { if (owner) arenaFree(arena, data); }
+
 	// reference to a tensor in the array
-	inline Tensor_t<T>& operator[] (int i) { return *array[i]; }
-	inline Tensor_t<T>* pointer(int i) { return array[i]; }
+	inline Tensor_t<T>& operator[] (int i) { assert(i >= 0 && i < N); return array[i]; }
+	inline Tensor_t<T>* pointer(int i) { assert(i >= 0 && i < N); return &array[i]; }
+
+	// the contiguous backing buffer and the distance between tensors in it (in elements)
+	inline T* buffer() const { return data; }
+	inline const int stride() const { return len; }
 
 	// dimension methods
 	inline const int count() const { return N; }
@@ -191,30 +528,43 @@ public:
 	inline const int height() const { return H; }
 	inline const int depth() const { return D; }
 	inline const int length() const { return len; }
+	inline tensorLayout_t layout() const { return order; }
 
-	// CSV dump
-    void csvDump(std::ostream& os, const char* name = NULL) {
+	// CSV dump: as Tensor_t::csvDump(), with the tensor index first on each line
+    void csvDump(std::ostream& os, const char* name = NULL) const {
+    	CsvWriter_t w(os);
+    	csvDump(w, name);
+    }
+    void csvDump(CsvWriter_t& w, const char* name = NULL) const {
     	// print optional array name
-    	if (name != NULL)
-    		os << name << std::endl;
+    	if (name != NULL) {
+    		w.put(name);
+    		w.endl();
+    	}
 
     	// print header
-     	os << "N,WH";
-	   	for (int k = 0; k < D; k++)
-    		os << "," << k;
-    	os << std::endl;
+     	w.put("N,WH");
+	   	for (int k = 0; k < D; k++) {
+	   		w.put(',');
+    		w.put(k);
+	   	}
+    	w.endl();
 
     	// print tensor
     	for (int n = 0; n < N; n++) {
 	    	for (int i = 0; i < W; i++) {
 	    		for (int j = 0; j < H; j++) {
-	    			os << n << "," << i << "x" << j;
-			    	for (int k = 0; k < D; k++)
-			    		if (std::is_floating_point<T>::value)
-			    			os << "," << (*this)[n](i, j, k);
-			    		else
-			    			os << "," << (int) (*this)[n](i, j, k);
-			    	os << std::endl;
+	    			const T *src = &array[n](i, j, 0);
+	    			w.put(n);
+	    			w.put(',');
+	    			w.put(i);
+	    			w.put('x');
+	    			w.put(j);
+			    	for (int k = 0; k < D; k++, src += array[n].channelStride()) {
+			    		w.put(',');
+			    		csvPut(w, *src);
+			    	}
+			    	w.endl();
 		   		}
 	    	}
 	    }
@@ -222,16 +572,30 @@ public:
 
 	// generate a string with geometry info
     std::string operator() () const {
-	   	static std::ostringstream buffer;
+	   	std::ostringstream buffer;
 	    buffer << N << " X [" << W << "," << H << "," << D << "]";
 	    return buffer.str();
     }
 
 private:
-	typename Tensor_t<T>::TensorPtr_t *array;
+	T *data;
+	Arena_t *arena;		// where "data" came from (NULL = heap)
+	bool owner;			// false if "data" is borrowed
+	std::vector<Tensor_t<T> > array;
 	const int W, H, D;
 	const int len;
 	const int N;
+	const tensorLayout_t order;
+
+	// no assignment of whole arrays
+	TensorArray_t<T>& operator= (const TensorArray_t<T>&);
+
+	// create the tensors on the buffer
+	void bind() {
+		array.reserve(N);
+		for (int i = 0; i < N; i++)
+			array.push_back(Tensor_t<T>(&data[i * len], W, H, D, order));
+	}
 }; 
 
 #endif // _TENSORH_
@@ -0,0 +1,110 @@
+/**
+ * @file tensorfile.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief binary tensor files: a fixed header and an aligned payload, read zero-copy through mmap.
+ */
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <string>
+#include "tensorfile.h"
+
+// size of one element of a dtype
+size_t tensorDtypeSize(int dtype) {
+	switch (dtype) {
+		case TENSOR_INT8:
+			return 1;
+		case TENSOR_INT32:
+		case TENSOR_FLOAT32:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+// map a file and check its header
+bool TensorFile_t::open(const char *path, std::string& error) {
+	struct stat st;
+	int fd;
+
+	close();
+	error = std::string(path) + ": ";
+	if ((fd = ::open(path, O_RDONLY)) < 0) {
+		error += strerror(errno);
+		return false;
+	}
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(tensorFileHeader_t)) {
+		error += "not a tensor file";
+		::close(fd);
+		return false;
+	}
+	void *map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED) {
+		error += strerror(errno);
+		return false;
+	}
+	base = (char *) map;
+	size = st.st_size;
+
+	const tensorFileHeader_t& h = header();
+	uint64_t elements = (uint64_t) h.N * h.W * h.H * h.D;
+	if (memcmp(h.magic, tensorFileMagic, sizeof(h.magic)))
+		error += "not a tensor file";
+	else if (h.version != tensorFileVersion)
+		error += "unsupported version " + std::to_string(h.version);
+	else if (!tensorDtypeSize(h.dtype) || (h.layout != TENSOR_LAYOUT_CHW && h.layout != TENSOR_LAYOUT_HWC))
+		error += "unsupported dtype or layout";
+	else if (!h.N || !h.W || !h.H || !h.D || elements > 0x7fffffff || h.bytes != elements * tensorDtypeSize(h.dtype))
+		error += "bad dimensions";
+	else if (h.offset % tensorFileAlign || h.offset < sizeof(tensorFileHeader_t) || h.offset + h.bytes > size)
+		error += "truncated or misaligned payload";
+	else {
+		error.clear();
+		return true;
+	}
+	close();
+	return false;
+}
+
+// unmap
+void TensorFile_t::close() {
+	if (base)
+		munmap(base, size);
+	base = NULL;
+	size = 0;
+}
+
+// write the header, padding up to the aligned payload offset, and the payload
+bool TensorFile_t::write(const char *path, const void *data, int dtype, tensorLayout_t layout, int N, int W, int H, int D, std::string& error) {
+	tensorFileHeader_t h;
+	static const char pad[tensorFileAlign] = { 0 };
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, tensorFileMagic, sizeof(h.magic));
+	h.version = tensorFileVersion;
+	h.dtype = dtype;
+	h.layout = layout;
+	h.N = N; h.W = W; h.H = H; h.D = D;
+	h.offset = (sizeof(h) + tensorFileAlign - 1) / tensorFileAlign * tensorFileAlign;
+	h.bytes = (uint64_t) N * W * H * D * tensorDtypeSize(dtype);
+
+	FILE *fp = fopen(path, "wb");
+	if (fp == NULL) {
+		error = std::string(path) + ": " + strerror(errno);
+		return false;
+	}
+	bool ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+			fwrite(pad, 1, h.offset - sizeof(h), fp) == h.offset - sizeof(h) &&
+			fwrite(data, 1, h.bytes, fp) == h.bytes;
+	if (fclose(fp) != 0)
+		ok = false;
+	if (!ok)
+		error = std::string(path) + ": write failed";
+	return ok;
+}
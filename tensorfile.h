@@ -0,0 +1,116 @@
+/**
+ * @file tensorfile.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief binary tensor files: a fixed header and an aligned payload, read zero-copy through mmap.
+ */
+#ifndef _TENSORFILE_H_
+#define _TENSORFILE_H_
+#include <stdint.h>
+#include <assert.h>
+#include <string>
+#include "tensor.h"
+
+// element types of a tensor file
+enum tensorDtype_t {
+	TENSOR_INT8 = 1,
+	TENSOR_INT32 = 2,
+	TENSOR_FLOAT32 = 3
+};
+
+// the dtype of a C++ element type
+template <typename T> struct tensorDtypeOf;
+template <> struct tensorDtypeOf<int8_t> { static const int value = TENSOR_INT8; };
+template <> struct tensorDtypeOf<int32_t> { static const int value = TENSOR_INT32; };
+template <> struct tensorDtypeOf<float> { static const int value = TENSOR_FLOAT32; };
+
+// tensorFileHeader_t: the 64 bytes at the start of a tensor file. The payload holds N tensors of W x H x D elements of
+// "dtype" back to back, each in "layout" order (tensorLayout_t, see tensor.h); it starts at byte "offset" (a multiple
+// of 64) and is "bytes" long. Everything is little endian.
+struct tensorFileHeader_t {
+	char magic[8];						// tensorFileMagic
+	uint32_t version;					// tensorFileVersion
+	uint32_t dtype;						// tensorDtype_t
+	uint32_t layout;					// tensorLayout_t
+	uint32_t N, W, H, D;
+	uint32_t reserved0;
+	uint64_t offset;					// payload start
+	uint64_t bytes;						// payload size
+	uint8_t reserved[8];
+};
+static_assert(sizeof(tensorFileHeader_t) == 64, "tensor file header must be 64 bytes");
+
+static const char tensorFileMagic[8] = { 'L', 'I', 'T', 'E', 'N', 'S', 'O', 'R' };
+static const uint32_t tensorFileVersion = 1;
+static const uint64_t tensorFileAlign = 64;
+
+// size of one element of a dtype, 0 if unknown
+extern size_t tensorDtypeSize(int dtype);
+
+// TensorFile_t class
+// A tensor file mapped into memory (copy on write, so tensors on it may be modified without touching the file).
+// tensor() and array() wrap the payload without copying it; they must not outlive the TensorFile_t.
+class TensorFile_t {
+public:
+	TensorFile_t() : base(NULL), size(0) {}
+	virtual ~TensorFile_t() { close(); }
+
+	// map a file; false (with the reason in "error") if it can't be read or isn't a valid tensor file
+	bool open(const char *path, std::string& error);
+
+	// unmap
+	void close();
+
+	// header fields
+	inline const tensorFileHeader_t& header() const { return *(const tensorFileHeader_t *) base; }
+	inline int count() const { return header().N; }
+	inline int width() const { return header().W; }
+	inline int height() const { return header().H; }
+	inline int depth() const { return header().D; }
+	inline tensorLayout_t layout() const { return (tensorLayout_t) header().layout; }
+
+	// true if the payload holds elements of type T
+	template <typename T>
+	inline bool holds() const { return base && header().dtype == (uint32_t) tensorDtypeOf<T>::value; }
+
+	// tensor n, or all tensors, on the mapped payload
+	template <typename T>
+	Tensor_t<T> *tensor(int n = 0) const {
+		assert(holds<T>() && n >= 0 && n < count());
+		return new Tensor_t<T>(payload<T>() + (size_t) n * width() * height() * depth(), width(), height(), depth(), layout());
+	}
+	template <typename T>
+	TensorArray_t<T> *array() const {
+		assert(holds<T>());
+		return new TensorArray_t<T>(payload<T>(), count(), width(), height(), depth(), layout());
+	}
+
+	// write N tensors of W x H x D elements in "layout" at "data" to a file; tensors and arrays record their own layout
+	template <typename T>
+	static bool write(const char *path, const T *data, int N, int W, int H, int D, std::string& error, tensorLayout_t layout = TENSOR_LAYOUT_CHW) {
+		return write(path, data, tensorDtypeOf<T>::value, layout, N, W, H, D, error);
+	}
+	template <typename T>
+	static bool write(const char *path, const Tensor_t<T>& t, std::string& error) {
+		return write(path, &t(0, 0, 0), 1, t.width(), t.height(), t.depth(), error, t.layout());
+	}
+	template <typename T>
+	static bool write(const char *path, const TensorArray_t<T>& t, std::string& error) {
+		return write(path, t.buffer(), t.count(), t.width(), t.height(), t.depth(), error, t.layout());
+	}
+
+private:
+	char *base;							// the mapping
+	size_t size;
+
+	template <typename T>
+	inline T *payload() const { return (T *) (base + header().offset); }
+
+	static bool write(const char *path, const void *data, int dtype, tensorLayout_t layout, int N, int W, int H, int D, std::string& error);
+
+	// no copies of a mapping
+	TensorFile_t(const TensorFile_t&);
+	TensorFile_t& operator= (const TensorFile_t&);
+};
+
+#endif // _TENSORFILE_H_
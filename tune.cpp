@@ -0,0 +1,76 @@
+/**
+ * @file tune.cpp
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief dataflows of the simulated conv layer, and the on-disk cache of the autotuner's choices.
+ */
+#include <stdio.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "tune.h"
+
+static const char *dataflowNames[] = { "auto", "os-channel", "os-surface", "ws", "is" };
+static const char *metricNames[] = { "time", "bytes" };
+
+// names of dataflows and metrics
+const char *convDataflowName(int flow) {
+	return flow >= CONV_FLOW_AUTO && flow <= convDataflows ? dataflowNames[flow] : "unknown";
+}
+
+int convDataflowByName(const std::string& name) {
+	for (int flow = CONV_FLOW_AUTO; flow <= convDataflows; flow++)
+		if (name == dataflowNames[flow])
+			return flow;
+	return -1;
+}
+
+const char *convTuneMetricName(int metric) {
+	return metric == CONV_TUNE_BYTES ? metricNames[1] : metricNames[0];
+}
+
+// read the file; a missing file is an empty cache, and lines that don't parse are skipped
+void TuningCache_t::load() {
+	std::ifstream is(path.c_str());
+	std::string line;
+
+	loaded = true;
+	while (std::getline(is, line)) {
+		size_t hash = line.find('#');
+		if (hash != std::string::npos)
+			line.erase(hash);
+		size_t colon = line.find(" : ");
+		if (colon == std::string::npos)
+			continue;
+		std::string name = line.substr(colon + 3);
+		name.erase(name.find_last_not_of(" \t") + 1);
+		int flow = convDataflowByName(name);
+		if (flow > CONV_FLOW_AUTO)
+			entries[line.substr(0, colon)] = flow;
+	}
+}
+
+// the cached dataflow for "key"
+bool TuningCache_t::lookup(const std::string& key, int& flow) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!loaded)
+		load();
+	std::map<std::string, int>::const_iterator it = entries.find(key);
+	if (it == entries.end())
+		return false;
+	flow = it->second;
+	return true;
+}
+
+// remember "flow" for "key" and append it to the file
+void TuningCache_t::record(const std::string& key, int flow, const std::string& scores) {
+	std::lock_guard<std::mutex> guard(lock);
+	if (!loaded)
+		load();
+	entries[key] = flow;
+	std::ofstream os(path.c_str(), std::ios::app);
+	if (os)
+		os << key << " : " << convDataflowName(flow) << " # " << scores << std::endl;
+	else
+		perror(path.c_str());
+}
@@ -0,0 +1,64 @@
+/**
+ * @file tune.h
+ * @author m.shebanow
+ * @date 10/17/2026
+ * @brief dataflows of the simulated conv layer, and the on-disk cache of the autotuner's choices.
+ */
+#ifndef _TUNE_H_
+#define _TUNE_H_
+#include <string>
+#include <map>
+#include <mutex>
+
+// dataflows of simulatedConv2D() (option_dataflow): which operand stays in the multiplier while the other streams through
+enum convDataflow_t {
+	CONV_FLOW_AUTO = 0,				// the tuning cache's choice for the shape, else CONV_FLOW_OS_CHANNEL
+	CONV_FLOW_OS_CHANNEL,			// output stationary, channel tiles outer: accumulators stay, tiles and vectors reload each step
+	CONV_FLOW_OS_SURFACE,			// output stationary, surface tiles outer
+	CONV_FLOW_WS,					// weight stationary: each filter tile loads once and every surface tile streams through it
+	CONV_FLOW_IS					// input stationary: each vector slice loads once and every channel tile streams past it
+};
+static const int convDataflows = CONV_FLOW_IS;
+
+// what the autotuner minimizes (option_tuneMetric)
+enum convTuneMetric_t {
+	CONV_TUNE_TIME = 0,				// host simulation time
+	CONV_TUNE_BYTES = 1				// modeled bytes loaded into the multiplier
+};
+
+// names of dataflows and metrics; convDataflowByName() returns -1 for an unknown name
+extern const char *convDataflowName(int flow);
+extern int convDataflowByName(const std::string& name);
+extern const char *convTuneMetricName(int metric);
+
+// TuningCache_t class
+// The best dataflow per layer shape, as found by the autotuner, in a text file with one line per entry:
+//
+//		<key> : <dataflow> [# scores]
+//
+// Keys describe the shape, the multiplier and the tuning metric (see simulatedConv2D()); the last line of a key wins.
+// The file is read on first use, and new entries are appended as they are found, so several runs can share it.
+// Lookups and records may come from several threads.
+class TuningCache_t {
+public:
+	TuningCache_t(const std::string& _path) : path(_path), loaded(false) {}
+
+	// the cached dataflow for "key"; false if there is none
+	bool lookup(const std::string& key, int& flow);
+
+	// remember "flow" for "key" and append it to the file, with "scores" as a comment
+	void record(const std::string& key, int flow, const std::string& scores);
+
+	// file name
+	inline const std::string& file() const { return path; }
+
+private:
+	std::string path;
+	bool loaded;
+	std::map<std::string, int> entries;
+	std::mutex lock;
+
+	void load();
+};
+
+#endif // _TUNE_H_
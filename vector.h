@@ -7,37 +7,138 @@
 #ifndef _VECTOR_H_
 #define _VECTOR_H_
 #include <assert.h>
+#include <cstring>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
+#include "arena.h"
 
 // class forward declarations.
 template <typename T> class Matrix_t;
 template <typename T> class Tensor_t;
+template <typename T> class TensorView_t;
+
+// VectorView_t class
+// A non-owning view of W contiguous elements (a vector, a slice of one, or a matrix row). Views are cheap to copy and 
+// never allocate; they are only valid while the storage they point at is.
+template <typename T>
+class VectorView_t {
+public:
+	// Constructor
+	VectorView_t(T *_data, int _W) : data(_data), W(_W) {}
+
+	// return a reference to a view member
+	inline T& operator()(int i) const { assert(i >= 0 && i < W); return data[i]; }
+	inline T& operator[](int i) const { assert(i >= 0 && i < W); return data[i]; }
+	inline T* pointer(int i = 0) const { assert(i >= 0 && i < W); return &data[i]; }
+
+	// dimension methods
+	inline const int width() const { return W; }
+	inline const int length() const { return W; }
+
+	// view of a slice of this view
+	VectorView_t<T> view(const int offset, const int len) const {
+		assert(offset >= 0 && len >= 0 && (offset + len) <= W);
+		return VectorView_t<T>(&data[offset], len);
+	}
+
+	// View Dot product
+	T operator* (const VectorView_t<T>& v) const {
+		T accumulator = 0;
+
+		assert(W == v.W);
+		for (int i = 0; i < W; i++)
+			accumulator += data[i] * v.data[i];
+		return accumulator;
+	}
+
+private:
+	T *data;
+	int W;
+};
 
 // Vector_t class 
 template <typename T>
 class Vector_t {
 public:
 	// Vector Constructor
-	Vector_t(int _W) : W(_W) { 
-		data = new T[W];
+	Vector_t(int _W) : owner(true), W(_W) { 
+		data = arenaAllocate<T>(arena = Arena_t::current(), W);
 		for (int i = 0; i < W; i++)
 			data[i] = 0;
 	}
 
+	// Vector constructor on borrowed storage: wraps W elements at "storage" (not zeroed, not freed). 
+	// Used by VectorArray_t for the vectors in its contiguous buffer.
+	Vector_t(T *storage, int _W) : data(storage), arena(NULL), owner(false), W(_W) {}
+
 	// Vector Copy Constructor
-	Vector_t(const Vector_t<T>& t) : W(t.W) { 
-		data = new T[W];
+	Vector_t(const Vector_t<T>& t) : owner(true), W(t.W) { 
+		data = arenaAllocate<T>(arena = Arena_t::current(), W);
 		for (int i = 0; i < W; i++)
 			data[i] = t.data[i];
 	}
 
+	// Vector Move Constructor; takes over the storage of "t"
+	Vector_t(Vector_t<T>&& t) : data(t.data), arena(t.arena), owner(t.owner), W(t.W) { 
+		t.data = NULL;
+		t.arena = NULL;
+		t.W = 0;
+	}
+
+	// Vector materializing constructor; copies the elements of a view
+	explicit Vector_t(const VectorView_t<T>& v) : owner(true), W(v.width()) {
+		data = arenaAllocate<T>(arena = Arena_t::current(), W);
+		if (W)
+			memcpy(data, v.pointer(), W * sizeof(T));
+	}
+
 	// Vector destructor
-	virtual ~Vector_t() { delete data; }
+	virtual ~Vector_t() { if (owner) arenaFree(arena, data); }
+
+	// Vector assignment: copy (deep) and move. A vector on borrowed storage is overwritten in place instead.
+	Vector_t<T>& operator= (const Vector_t<T>& t) {
+		if (this != &t) {
+			if (!owner) {
+				assert(W == t.W);
+				memcpy(data, t.data, W * sizeof(T));
+			} else {
+				Vector_t<T> copy(t);
+				swap(copy);
+			}
+		}
+		return *this;
+	}
+	Vector_t<T>& operator= (Vector_t<T>&& t) {
+		if (this != &t) {
+			if (!owner || !t.owner)
+				*this = (const Vector_t<T>&) t;
+			else
+				swap(t);
+		}
+		return *this;
+	}
+
+	// exchange contents with another vector
+	void swap(Vector_t<T>& t) {
+		std::swap(data, t.data);
+		std::swap(arena, t.arena);
+		std::swap(owner, t.owner);
+		std::swap(W, t.W);
+	}
+
+	// non-owning view of the whole vector or of a slice of it
+	VectorView_t<T> view() const { return VectorView_t<T>(data, W); }
+	VectorView_t<T> view(const int offset, const int len) const {
+		assert(offset >= 0 && len >= 0 && (offset + len) <= W);
+		return VectorView_t<T>(&data[offset], len);
+	}
 
 	// return a reference to a tensor member
 	inline T& operator()(int i) { assert(i >= 0 && i < W); return data[i]; }
 	inline T& operator[](int i) { assert(i >= 0 && i < W); return data[i]; }
+	inline T* pointer(int i = 0) { assert(i >= 0 && i < W); return &data[i]; }
 
 	// dimension methods
 	inline const int width() const { return W; }
@@ -74,7 +175,7 @@ public:
 
 	// Generate a string with vector geoemtry
 	std::string operator() () const {
-	   	static std::ostringstream buffer;
+	   	std::ostringstream buffer;
 	    buffer << "[" << W << "]";
 	    return buffer.str();
 	}
@@ -101,44 +202,58 @@ public:
     // allow serialization friend function access to private data
     template <typename U>
 	friend void serializeTensor2Vector(Vector_t<U> &, const Tensor_t<U> &);
+    template <typename U>
+	friend void serializeTensor2Vector(Vector_t<U> &, const TensorView_t<U> &);
 
 private:
 	T *data;
-	const int W;
+	Arena_t *arena;		// where "data" came from (NULL = heap)
+	bool owner;			// false if "data" is borrowed storage
+	int W;
 
 	template <typename TT> friend class Matrix_t;
 	template <typename TT> friend class Tensor_t;
 };
 
 // VectorArray_t class
+// The N vectors live back to back in one 64-byte aligned buffer; vector i starts at buffer() + i * stride(). 
+// The buffer can be handed as is to a kernel or a writer. operator[] returns a Vector_t on that storage.
 template <typename T>
 class VectorArray_t {
 public:
 	// Constructor
 	VectorArray_t(int _N = 1, int _W = 1) : N(_N), W(_W), len(_W) {
-		array = new typename Vector_t<T>::VectorPtr_t[N];
-		for (int i = 0; i < N; i++)
-			array[i] = new Vector_t<T>(W);
+		data = arenaAllocate<T>(arena = Arena_t::current(), N * len);
+		memset(data, 0, N * len * sizeof(T));
+		bind();
 	}
 
 	// generic copy constructor
 	template <typename U> friend class VectorArray_t;
 	template <typename U>
 	VectorArray_t(const VectorArray_t<U>& v) : N(v.N), W(v.W), len(v.len) { 
-		array = new typename Vector_t<T>::VectorPtr_t[v.N];
-		for (int i = 0; i < N; i++)
-			array[i] = new Vector_t<T>(*v.array[i]);
+		data = arenaAllocate<T>(arena = Arena_t::current(), N * len);
+		for (int i = 0; i < N * len; i++)
+			data[i] = (T) v.data[i];
+		bind();
 	}
 
-	// Destructor
-	virtual ~VectorArray_t() {
-		for (int i = 0; i < N; i++)
-			delete array[i];
-		delete[] array;
+	// copy constructor
+	VectorArray_t(const VectorArray_t<T>& v) : N(v.N), W(v.W), len(v.len) { 
+		data = arenaAllocate<T>(arena = Arena_t::current(), N * len);
+		memcpy(data, v.data, N * len * sizeof(T));
+		bind();
 	}
 
-	// reference to a tensor in the array
-	inline Vector_t<T>& operator[] (int i) { return *array[i]; }
+	// Destructor
+	virtual ~VectorArray_t() { arenaFree(arena, data); }
+
+	// reference to a vector in the array
+	inline Vector_t<T>& operator[] (int i) { assert(i >= 0 && i < N); return array[i]; }
+
+	// the contiguous backing buffer and the distance between vectors in it (in elements)
+	inline T* buffer() const { return data; }
+	inline const int stride() const { return len; }
 
 	// dimension methods
 	inline const int count() const { return N; }
@@ -147,16 +262,28 @@ public:
 
 	// generate a string with geometry info
     std::string operator() () const {
-	   	static std::ostringstream buffer;
+	   	std::ostringstream buffer;
 	    buffer << N << " X [" << W << "]";
 	    return buffer.str();
     }
 
 private:
-	typename Vector_t<T>::VectorPtr_t *array;
+	T *data;
+	Arena_t *arena;		// where "data" came from (NULL = heap)
+	std::vector<Vector_t<T> > array;
 	const int W;
 	const int len;
 	const int N;
+
+	// no assignment of whole arrays
+	VectorArray_t<T>& operator= (const VectorArray_t<T>&);
+
+	// create the vectors on the buffer
+	void bind() {
+		array.reserve(N);
+		for (int i = 0; i < N; i++)
+			array.push_back(Vector_t<T>(&data[i * len], W));
+	}
 };
 
 #endif // _VECTOR_H_